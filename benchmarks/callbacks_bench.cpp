@@ -0,0 +1,130 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+//compares callbacks fan-out through type erased std::function
+//(how callbacks_holder dispatched before) with inlined template dispatch
+//for 1, 10 and 1000 subscribers.
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "callbacks_holder.h"
+
+namespace {
+
+struct bench_callback
+{
+    virtual ~bench_callback() {}
+    virtual void event( int e ) = 0;
+};
+
+struct counting_callback : public bench_callback
+{
+    counting_callback() : sum( 0 ) {}
+    void event( int e ) override
+        { sum += e; }
+
+    volatile long long sum;
+};
+
+class bench_holder : public callbacks_holder<bench_callback>
+{
+public:
+    ~bench_holder()
+        { clear_callbacks(); }
+
+    //dispatch as it was done before: through std::function
+    void notify_erased( int e )
+    {
+        for_each_erased(
+            [e] ( bench_callback* callback )
+            {
+                callback->event( e );
+            }
+        );
+    }
+
+    void notify( int e )
+    {
+        for_each_callback(
+            [e] ( bench_callback* callback )
+            {
+                callback->event( e );
+            }
+        );
+    }
+
+private:
+    void for_each_erased( const std::function<void( bench_callback* )>& f )
+        { for_each_callback( f ); }
+};
+
+template<typename F>
+double measure( unsigned iterations, F&& f )
+{
+    typedef std::chrono::high_resolution_clock clock;
+
+    const clock::time_point start = clock::now();
+    for( unsigned i = 0; i < iterations; ++i )
+        f( static_cast<int>( i ) );
+    const clock::time_point end = clock::now();
+
+    return std::chrono::duration<double, std::nano>( end - start ).count() / iterations;
+}
+
+void run( unsigned subscribers, unsigned iterations )
+{
+    bench_holder holder;
+    std::vector<std::unique_ptr<counting_callback> > callbacks;
+    for( unsigned i = 0; i < subscribers; ++i ) {
+        callbacks.emplace_back( new counting_callback );
+        holder.register_callback( callbacks.back().get() );
+    }
+
+    //warm up
+    measure( iterations / 10, [&holder] ( int e ) { holder.notify( e ); } );
+
+    const double erased =
+        measure( iterations, [&holder] ( int e ) { holder.notify_erased( e ); } );
+    const double inlined =
+        measure( iterations, [&holder] ( int e ) { holder.notify( e ); } );
+
+    std::printf( "%5u subscribers: %9.1f ns -> %9.1f ns per event\n",
+                 subscribers, erased, inlined );
+}
+
+}
+
+int main()
+{
+    run( 1, 10000000 );
+    run( 10, 2000000 );
+    run( 1000, 20000 );
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+//measures vlc::player playlist storage:
+//heap per item (media and lazy items), append, advance_item and delete_item.
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "vlc_player.h"
+
+namespace {
+
+//live heap bytes allocated with operator new
+size_t live_bytes = 0;
+
+//keeps allocation size before returned block
+const size_t HEADER_SIZE = 16;
+
+}
+
+void* operator new( size_t size )
+{
+    char* p = static_cast<char*>( malloc( size + HEADER_SIZE ) );
+    if( !p )
+        throw std::bad_alloc();
+
+    *reinterpret_cast<size_t*>( p ) = size;
+    live_bytes += size;
+
+    return p + HEADER_SIZE;
+}
+
+void operator delete( void* block ) noexcept
+{
+    if( !block )
+        return;
+
+    char* p = static_cast<char*>( block ) - HEADER_SIZE;
+    live_bytes -= *reinterpret_cast<size_t*>( p );
+    free( p );
+}
+
+namespace {
+
+typedef std::chrono::steady_clock bench_clock;
+
+double elapsed_us( bench_clock::time_point start )
+{
+    return std::chrono::duration<double, std::micro>( bench_clock::now() - start ).count();
+}
+
+void run_media( libvlc_instance_t* instance, unsigned count )
+{
+    std::vector<vlc::media> media;
+    media.reserve( count );
+    for( unsigned i = 0; i < count; ++i ) {
+        const std::string mrl = "file:///media/" + std::to_string( i ) + ".mkv";
+        media.push_back(
+            vlc::media::create_media( instance, mrl.c_str(), 0, nullptr, 0, nullptr, false ) );
+    }
+
+    vlc::player player;
+    player.open( instance );
+
+    const size_t start_bytes = live_bytes;
+    bench_clock::time_point start = bench_clock::now();
+    for( unsigned i = 0; i < count; ++i )
+        player.add_media( media[i] );
+    const double append_us = elapsed_us( start );
+    const size_t bytes = live_bytes - start_bytes;
+
+    for( unsigned i = 0; i < count; ++i )
+        player.set_item_data( i, i % 2 ? "group-a" : "group-b" );
+    const size_t data_bytes = live_bytes - start_bytes;
+
+    //delete_item expects current item
+    player.set_current( 0 );
+
+    const unsigned iterations = 2000;
+
+    start = bench_clock::now();
+    for( unsigned i = 0; i < iterations; ++i )
+        player.advance_item( count / 2, static_cast<int>( count / 4 ) );
+    const double advance_us = elapsed_us( start );
+
+    start = bench_clock::now();
+    for( unsigned i = 0; i < iterations; ++i )
+        player.delete_item( count / 2 - i - 1 );
+    const double delete_us = elapsed_us( start );
+
+    player.close();
+
+    std::printf( "%u media items:\n"
+                 "  heap per item:         %8.1f bytes (%.1f with item data)\n"
+                 "  add_media:             %8.1f ns\n"
+                 "  advance_item by N/4:   %8.2f us\n"
+                 "  delete_item in middle: %8.2f us\n",
+                 count,
+                 double( bytes ) / count, double( data_bytes ) / count,
+                 append_us * 1000 / count,
+                 advance_us / iterations,
+                 delete_us / iterations );
+}
+
+void run_lazy( libvlc_instance_t* instance, unsigned count )
+{
+    std::vector<std::string> mrls;
+    std::vector<const char*> mrl_ptrs;
+    mrls.reserve( count );
+    for( unsigned i = 0; i < count; ++i ) {
+        mrls.push_back( "file:///media/" + std::to_string( i ) + ".mkv" );
+        mrl_ptrs.push_back( mrls.back().c_str() );
+    }
+
+    vlc::player player;
+    player.open( instance );
+
+    const size_t start_bytes = live_bytes;
+    const bench_clock::time_point start = bench_clock::now();
+    player.add_media_items( mrl_ptrs.data(), count, 0, nullptr );
+    const double append_us = elapsed_us( start );
+    const size_t bytes = live_bytes - start_bytes;
+
+    player.close();
+
+    std::printf( "%u lazy items:\n"
+                 "  heap per item:         %8.1f bytes\n"
+                 "  add_media_items:       %8.1f ns per item\n",
+                 count,
+                 double( bytes ) / count,
+                 append_us * 1000 / count );
+}
+
+}
+
+int main()
+{
+    libvlc_instance_t* instance = libvlc_new( 0, nullptr );
+    if( !instance ) {
+        std::fprintf( stderr, "libvlc_new failed\n" );
+        return 1;
+    }
+
+    run_media( instance, 30000 );
+    run_lazy( instance, 30000 );
+
+    libvlc_release( instance );
+
+    return 0;
+}
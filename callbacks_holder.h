@@ -26,63 +26,347 @@
 #pragma once
 
 #include <cassert>
-#include <deque>
-#include <functional>
-#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <atomic>
+#include <thread>
 #include <mutex>
 
 template<typename callback_t>
 class callbacks_holder
 {
+private:
+    struct callback_node;
+    typedef std::shared_ptr<callback_node> callback_node_ptr;
+
 protected:
     ~callbacks_holder();
 
 public:
-    virtual void register_callback( callback_t* );
-    virtual void unregister_callback( callback_t* );
+    //meaning of every bit is defined by derived class
+    typedef unsigned events_mask_t;
+
+    //identifies registered callback, allows to unregister it in O(1)
+    class handle
+    {
+    public:
+        handle() {}
+
+        explicit operator bool() const
+            { return static_cast<bool>( _node ); }
+
+    private:
+        friend class callbacks_holder;
+
+        explicit handle( const callback_node_ptr& node )
+            : _node( node ) {}
+
+        callback_node_ptr _node;
+    };
+
+    //safe to call from any thread, including from inside of callback.
+    //after unregister_callback return callback will not be called anymore
+    //(except if unregister_callback was called from inside of callback
+    //of the same holder on the same thread).
+    virtual handle register_callback( callback_t*,
+                                      events_mask_t events_mask = ~events_mask_t( 0 ) );
+    virtual void unregister_callback( const handle& );
+    void unregister_callback( callback_t* );
 
 protected:
-    void for_each_callback( const std::function<void( callback_t* )>& ) const;
+    callbacks_holder();
+
+    //doesn't take any lock, so never waits for register/unregister.
+    //f is called as f( callback_t* ) and is inlined (no type erasure, no allocations)
+    template<typename F>
+    void for_each_callback( F&& f ) const
+        { for_each_callback( ~events_mask_t( 0 ), std::forward<F>( f ) ); }
+    //calls f only for callbacks registered with any of bits from event_mask
+    template<typename F>
+    void for_each_callback( events_mask_t event_mask, F&& f ) const;
     bool has_callbacks() const
-        { return !_callbacks.empty(); }
-    void clear_callbacks()
-        { _callbacks.clear(); }
+        { return _callbacks_count != 0; }
+    //union of events masks of all registered callbacks
+    events_mask_t callbacks_events_mask() const
+        { return _events_mask; }
+    void clear_callbacks();
 
 private:
-    typedef std::deque<callback_t*> callbacks_t;
+    struct callback_node
+    {
+        callback_node( callback_t* callback, events_mask_t events_mask )
+            : callback( callback ), events_mask( events_mask ),
+              active( true ), in_call( 0 ) {}
+
+        callback_t *const callback;
+        const events_mask_t events_mask;
+        std::atomic<bool> active;
+        //count of dispatchers calling callback right now
+        std::atomic<unsigned> in_call;
+    };
+
+    //published array of callbacks. Items are only appended in place
+    //(while there is free capacity), unregistered callbacks are just marked
+    //inactive and are dropped when array is rebuilt,
+    //so readers never see modified items.
+    struct callbacks_t
+    {
+        explicit callbacks_t( size_t capacity )
+            : nodes( new callback_node_ptr[capacity] ),
+              capacity( capacity ), count( 0 ) {}
+
+        std::unique_ptr<callback_node_ptr[]> nodes;
+        const size_t capacity;
+        std::atomic<size_t> count;
+    };
+    typedef std::shared_ptr<callbacks_t> callbacks_ptr;
+
+    enum {
+        MIN_CAPACITY = 8,
+        MASK_BITS = sizeof( events_mask_t ) * 8,
+    };
+
+    callbacks_ptr snapshot() const
+        { return std::atomic_load( &_callbacks ); }
+    //should be called with _callbacks_guard locked
+    void rebuild( size_t capacity );
+    void deactivate( callback_node* node );
+    //should be called without _callbacks_guard locked,
+    //since callback can call register/unregister itself
+    void wait_dispatchers( callback_node* node ) const;
+
+    //dispatch of holder on current thread,
+    //frames of nested dispatches (of any holders) are linked into stack
+    struct dispatch_frame
+    {
+        explicit dispatch_frame( const callbacks_holder* holder )
+            : holder( holder ), prev( top() ) { top() = this; }
+        ~dispatch_frame()
+            { top() = prev; }
+
+        static dispatch_frame*& top()
+            { static thread_local dispatch_frame* frame = nullptr; return frame; }
+
+        const callbacks_holder *const holder;
+        dispatch_frame *const prev;
+    };
+    //this holder dispatches callbacks on current thread
+    bool is_dispatching() const;
 
 private:
-    mutable std::mutex _callbacks_guard;
-    callbacks_t _callbacks;
+    //serializes writers only
+    std::mutex _callbacks_guard;
+    callbacks_ptr _callbacks;
+    std::unordered_map<callback_t*, callback_node_ptr> _nodes;
+    //inactive nodes still kept in _callbacks
+    size_t _inactive_count;
+    //count of active callbacks interested in every event bit
+    unsigned _event_bit_users[MASK_BITS];
+
+    std::atomic<size_t> _callbacks_count;
+    std::atomic<events_mask_t> _events_mask;
 };
 
+template<typename callback_t>
+callbacks_holder<callback_t>::callbacks_holder()
+    : _callbacks( std::make_shared<callbacks_t>( MIN_CAPACITY ) ),
+      _inactive_count( 0 ), _callbacks_count( 0 ), _events_mask( 0 )
+{
+    for( unsigned& users: _event_bit_users )
+        users = 0;
+}
+
 template<typename callback_t>
 callbacks_holder<callback_t>::~callbacks_holder()
 {
-    assert( _callbacks.empty() );
+    assert( _nodes.empty() );
 }
 
 template<typename callback_t>
-void callbacks_holder<callback_t>::register_callback( callback_t* callback )
+void callbacks_holder<callback_t>::rebuild( size_t capacity )
+{
+    const callbacks_t& callbacks = *_callbacks;
+    const size_t count = callbacks.count;
+
+    callbacks_ptr new_callbacks = std::make_shared<callbacks_t>( capacity );
+    size_t new_count = 0;
+    for( size_t i = 0; i < count; ++i ) {
+        if( callbacks.nodes[i]->active )
+            new_callbacks->nodes[new_count++] = callbacks.nodes[i];
+    }
+    new_callbacks->count = new_count;
+
+    //dispatchers still using old array will skip inactive nodes
+    std::atomic_store( &_callbacks, new_callbacks );
+    _inactive_count = 0;
+}
+
+template<typename callback_t>
+void callbacks_holder<callback_t>::deactivate( callback_node* node )
+{
+    node->active = false;
+
+    events_mask_t events_mask = _events_mask;
+    for( unsigned bit = 0; bit < MASK_BITS; ++bit ) {
+        if( ( node->events_mask >> bit ) & 1 ) {
+            if( 0 == --_event_bit_users[bit] )
+                events_mask &= ~( events_mask_t( 1 ) << bit );
+        }
+    }
+    _events_mask = events_mask;
+
+    --_callbacks_count;
+    ++_inactive_count;
+}
+
+template<typename callback_t>
+bool callbacks_holder<callback_t>::is_dispatching() const
+{
+    for( const dispatch_frame* f = dispatch_frame::top(); f; f = f->prev ) {
+        if( f->holder == this )
+            return true;
+    }
+
+    return false;
+}
+
+template<typename callback_t>
+void callbacks_holder<callback_t>::wait_dispatchers( callback_node* node ) const
+{
+    //wait while dispatchers still call node callback,
+    //but only if we are not inside of dispatch of this holder ourselves
+    //(it would never end)
+    if( is_dispatching() )
+        return;
+
+    while( node->in_call )
+        std::this_thread::yield();
+}
+
+template<typename callback_t>
+typename callbacks_holder<callback_t>::handle
+callbacks_holder<callback_t>::register_callback( callback_t* callback,
+                                                 events_mask_t events_mask )
 {
     std::lock_guard<std::mutex> lock( _callbacks_guard );
-    assert( _callbacks.end() == std::find( _callbacks.begin(), _callbacks.end(), callback ) );
-    _callbacks.push_back( callback );
+
+    assert( _nodes.end() == _nodes.find( callback ) );
+
+    callback_node_ptr node = std::make_shared<callback_node>( callback, events_mask );
+    _nodes.emplace( callback, node );
+
+    if( _callbacks->count == _callbacks->capacity ) {
+        const size_t active_count = _callbacks_count;
+        size_t capacity = _callbacks->capacity;
+        while( capacity < ( active_count + 1 ) * 2 )
+            capacity *= 2;
+
+        rebuild( capacity );
+    }
+
+    //nobody reads items after count, so it's safe to append in place
+    callbacks_t& callbacks = *_callbacks;
+    const size_t count = callbacks.count;
+    callbacks.nodes[count] = node;
+    callbacks.count = count + 1;
+
+    for( unsigned bit = 0; bit < MASK_BITS; ++bit ) {
+        if( ( events_mask >> bit ) & 1 )
+            ++_event_bit_users[bit];
+    }
+    _events_mask = _events_mask | events_mask;
+
+    ++_callbacks_count;
+
+    return handle( node );
+}
+
+template<typename callback_t>
+void callbacks_holder<callback_t>::unregister_callback( const handle& h )
+{
+    callback_node_ptr node = h._node;
+    if( !node )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock( _callbacks_guard );
+
+        if( !node->active )
+            return;
+
+        auto it = _nodes.find( node->callback );
+        if( it == _nodes.end() || it->second != node )
+            return;
+
+        _nodes.erase( it );
+        deactivate( node.get() );
+
+        //removal itself is deferred until inactive nodes take half of array
+        if( _inactive_count > _callbacks_count )
+            rebuild( _callbacks->capacity );
+    }
+
+    wait_dispatchers( node.get() );
 }
 
 template<typename callback_t>
 void callbacks_holder<callback_t>::unregister_callback( callback_t* callback )
 {
-    std::lock_guard<std::mutex> lock( _callbacks_guard );
-    auto it = std::find( _callbacks.begin(), _callbacks.end(), callback );
-    if( it != _callbacks.end() ) {
-        _callbacks.erase( it );
+    handle h;
+
+    {
+        std::lock_guard<std::mutex> lock( _callbacks_guard );
+
+        auto it = _nodes.find( callback );
+        if( it == _nodes.end() )
+            return;
+
+        h = handle( it->second );
     }
+
+    unregister_callback( h );
 }
 
 template<typename callback_t>
-void callbacks_holder<callback_t>::for_each_callback( const std::function<void( callback_t* )>& f ) const
+void callbacks_holder<callback_t>::clear_callbacks()
 {
-    std::lock_guard<std::mutex> lock( _callbacks_guard );
-    std::for_each( _callbacks.begin(), _callbacks.end(), f );
+    callbacks_ptr callbacks;
+
+    {
+        std::lock_guard<std::mutex> lock( _callbacks_guard );
+
+        if( _nodes.empty() )
+            return;
+
+        for( auto& n: _nodes )
+            deactivate( n.second.get() );
+        _nodes.clear();
+
+        callbacks = _callbacks;
+        rebuild( MIN_CAPACITY );
+    }
+
+    for( size_t i = 0; i < callbacks->count; ++i )
+        wait_dispatchers( callbacks->nodes[i].get() );
+}
+
+template<typename callback_t>
+template<typename F>
+void callbacks_holder<callback_t>::for_each_callback( events_mask_t event_mask, F&& f ) const
+{
+    const callbacks_ptr callbacks = snapshot();
+    const size_t count = callbacks->count;
+
+    const dispatch_frame frame( this );
+    for( size_t i = 0; i < count; ++i ) {
+        callback_node* node = callbacks->nodes[i].get();
+        if( !( node->events_mask & event_mask ) )
+            continue;
+
+        ++node->in_call;
+        if( node->active )
+            f( node->callback );
+        --node->in_call;
+    }
 }
@@ -11,6 +11,15 @@ HEADERS += $$PWD/vlc_vmem.h \
     $$PWD/vlc_playback.h \
     $$PWD/vlc_video.h \
     $$PWD/vlc_media.h \
+    $$PWD/vlc_events_coalescer.h \
+    $$PWD/vlc_event_dispatcher.h \
+    $$PWD/vlc_event_trace.h \
+    $$PWD/vlc_playlist_storage.h \
+    $$PWD/vlc_player_actor.h \
+    $$PWD/vlc_reaper.h \
+    $$PWD/vlc_media_player_pool.h \
+    $$PWD/vlc_instance_manager.h \
+    $$PWD/vlc_player_state.h \
     $$PWD/callbacks_holder.h
 
 SOURCES += $$PWD/vlc_vmem.cpp \
@@ -21,7 +30,16 @@ SOURCES += $$PWD/vlc_vmem.cpp \
     $$PWD/vlc_subtitles.cpp \
     $$PWD/vlc_playback.cpp \
     $$PWD/vlc_video.cpp\
-    $$PWD/vlc_media.cpp
+    $$PWD/vlc_media.cpp \
+    $$PWD/vlc_events_coalescer.cpp \
+    $$PWD/vlc_event_dispatcher.cpp \
+    $$PWD/vlc_event_trace.cpp \
+    $$PWD/vlc_playlist_storage.cpp \
+    $$PWD/vlc_player_actor.cpp \
+    $$PWD/vlc_reaper.cpp \
+    $$PWD/vlc_media_player_pool.cpp \
+    $$PWD/vlc_instance_manager.cpp \
+    $$PWD/vlc_player_state.cpp
 
 !android {
     HEADERS += $$PWD/vlc_media_list_player.h
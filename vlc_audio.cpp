@@ -25,13 +25,11 @@
 
 #include "vlc_audio.h"
 
-#include "vlc_helpers.h"
-
 using namespace vlc;
 
 void audio::notify( audio_event_e event )
 {
-    for_each_callback(
+    for_each_callback( 1u << static_cast<unsigned>( event ),
         [event] ( audio_events_callback* callback )
         {
             callback->audio_event( event );
@@ -86,9 +84,7 @@ unsigned audio::track_count()
     if( !_player.is_open() )
         return 0;
 
-    int tc = libvlc_audio_get_track_count( _player.get_mp() );
-
-    return tc < 0 ? 0 : tc ;
+    return _tracks.count( _player.get_mp() );
 }
 
 int audio::get_track()
@@ -96,17 +92,7 @@ int audio::get_track()
     if( !_player.is_open() )
         return -1;
 
-    int track_idx = -1;
-    libvlc_track_description_t* tracks =
-        libvlc_audio_get_track_description( _player.get_mp() );
-
-    if( tracks ) {
-        track_idx = track_id_2_track_idx( tracks, libvlc_audio_get_track( _player.get_mp() ) );
-
-        libvlc_free( tracks );
-    }
-
-    return track_idx;
+    return _tracks.id_2_idx( _player.get_mp(), libvlc_audio_get_track( _player.get_mp() ) );
 }
 
 void audio::set_track( unsigned idx )
@@ -114,15 +100,17 @@ void audio::set_track( unsigned idx )
     if( !_player.is_open() )
         return;
 
-    libvlc_track_description_t* tracks =
-        libvlc_audio_get_track_description( _player.get_mp() );
-
-    if( tracks ) {
-        int id = track_idx_2_track_id( tracks, idx );
+    int id;
+    if( _tracks.idx_2_id( _player.get_mp(), idx, &id ) )
         libvlc_audio_set_track( _player.get_mp(), id );
+}
 
-        libvlc_free( tracks );
-    }
+std::string audio::get_track_name( unsigned idx )
+{
+    if( !_player.is_open() )
+        return std::string();
+
+    return _tracks.name( _player.get_mp(), idx );
 }
 
 libvlc_audio_output_channel_t audio::get_channel()
@@ -154,3 +142,31 @@ void audio::set_delay( int64_t d )
 
     libvlc_audio_set_delay( _player.get_mp(), d * 1000 );
 }
+
+void audio::set_callbacks( libvlc_audio_play_cb play,
+                           libvlc_audio_pause_cb pause,
+                           libvlc_audio_resume_cb resume,
+                           libvlc_audio_flush_cb flush,
+                           libvlc_audio_drain_cb drain,
+                           void* opaque )
+{
+    if( !_player.is_open() )
+        return;
+
+    //pool can't reset audio callbacks
+    _player.disable_pool_reuse();
+
+    libvlc_audio_set_callbacks( _player.get_mp(),
+                                play, pause, resume, flush, drain, opaque );
+}
+
+void audio::set_format_callbacks( libvlc_audio_setup_cb setup,
+                                  libvlc_audio_cleanup_cb cleanup )
+{
+    if( !_player.is_open() )
+        return;
+
+    _player.disable_pool_reuse();
+
+    libvlc_audio_set_format_callbacks( _player.get_mp(), setup, cleanup );
+}
@@ -28,6 +28,7 @@
 #include "callbacks_holder.h"
 
 #include "vlc_basic_player.h"
+#include "vlc_helpers.h"
 
 namespace vlc
 {
@@ -37,6 +38,7 @@ namespace vlc
         volume_changed,
     };
 
+    //every audio_event_e has bit ( 1 << e ) in events mask
     struct audio_events_callback
     {
         virtual void audio_event( audio_event_e e ) = 0;
@@ -47,7 +49,7 @@ namespace vlc
     {
     public:
         audio( vlc::basic_player& player )
-            : _player( player ) {};
+            : _player( player ), _tracks( libvlc_audio_get_track_description ) {};
 
         bool is_muted();
         void toggle_mute();
@@ -60,6 +62,14 @@ namespace vlc
         //can return -1 if there is no active audio track
         int get_track();
         void set_track( unsigned );
+        std::string get_track_name( unsigned idx );
+
+        //if enabled, audio tracks table is kept between queries
+        //until invalidate_tracks (player_core does it on media player events)
+        void set_tracks_cache( bool enable )
+            { _tracks.set_enabled( enable ); }
+        void invalidate_tracks()
+            { _tracks.invalidate(); }
 
         libvlc_audio_output_channel_t get_channel();
         void set_channel( libvlc_audio_output_channel_t );
@@ -68,10 +78,21 @@ namespace vlc
         int64_t get_delay();
         void set_delay( int64_t );
 
+        //player will not return media player to media_player_pool then
+        void set_callbacks( libvlc_audio_play_cb play,
+                            libvlc_audio_pause_cb pause,
+                            libvlc_audio_resume_cb resume,
+                            libvlc_audio_flush_cb flush,
+                            libvlc_audio_drain_cb drain,
+                            void* opaque );
+        void set_format_callbacks( libvlc_audio_setup_cb setup,
+                                   libvlc_audio_cleanup_cb cleanup );
+
     private:
         void notify( audio_event_e );
 
     private:
         vlc::basic_player& _player;
+        tracks_cache _tracks;
     };
 };
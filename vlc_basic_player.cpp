@@ -27,10 +27,13 @@
 
 #include <cassert>
 
+#include "vlc_reaper.h"
+#include "vlc_media_player_pool.h"
+
 using namespace vlc;
 
 basic_player::basic_player()
-    : _libvlc_instance( 0 ), _mp( 0 )
+    : _libvlc_instance( 0 ), _mp( 0 ), _reusable( true )
 {
 }
 
@@ -48,18 +51,60 @@ bool basic_player::open( libvlc_instance_t* inst )
         close();
 
     _libvlc_instance = inst;
-    _mp = libvlc_media_player_new( inst );
+    _reusable = true;
+    _mp = media_player_pool::acquire( inst );
+    if( !_mp )
+        _mp = libvlc_media_player_new( inst );
+
+    if( _mp )
+        _owner = std::make_shared<owner_token>();
 
     return 0 != _mp;
 }
 
+void basic_player::release_owner()
+{
+    std::weak_ptr<owner_token> owner = _owner;
+    _owner.reset();
+
+    //stop job keeps owner alive only while it's stopping media player,
+    //so media player should not be recycled before it's done
+    if( !owner.expired() && _pending_stop.valid() )
+        _pending_stop.wait();
+}
+
 void basic_player::close()
 {
     if( _mp ) {
-        libvlc_media_player_release( _mp );
+        release_owner();
+
+        //reaper keeps own reference to media player while stopping it
+        if( !_reusable || !media_player_pool::recycle( _libvlc_instance, _mp ) )
+            libvlc_media_player_release( _mp );
         _mp = 0;
     }
 
+    _pending_stop = std::shared_future<void>();
+    _libvlc_instance = 0;
+}
+
+void basic_player::close_async()
+{
+    //pending stop job is executed before this one anyway
+    _owner.reset();
+    _pending_stop = std::shared_future<void>();
+
+    if( libvlc_media_player_t* mp = _mp ) {
+        _mp = 0;
+        libvlc_instance_t* inst = _libvlc_instance;
+        const bool reusable = _reusable;
+        reaper::instance().post( [mp, inst, reusable] () {
+            libvlc_media_player_stop( mp );
+            if( !reusable || !media_player_pool::recycle( inst, mp ) )
+                libvlc_media_player_release( mp );
+        } );
+    }
+
     _libvlc_instance = 0;
 }
 
@@ -75,6 +120,16 @@ void basic_player::swap( basic_player* player )
     libvlc_media_player_t* tmp = player->_mp;
     player->_mp = _mp;
     _mp = tmp;
+
+    const bool tmp_reusable = player->_reusable;
+    player->_reusable = _reusable;
+    _reusable = tmp_reusable;
+
+    _owner.swap( player->_owner );
+
+    const std::shared_future<void> tmp_pending_stop = player->_pending_stop;
+    player->_pending_stop = _pending_stop;
+    _pending_stop = tmp_pending_stop;
 }
 
 libvlc_state_t basic_player::get_state()
@@ -87,6 +142,8 @@ libvlc_state_t basic_player::get_state()
 
 void basic_player::play()
 {
+    wait_pending_stop();
+
     if( is_open() )
         libvlc_media_player_play( _mp );
 }
@@ -105,22 +162,71 @@ void basic_player::togglePause()
 
 void basic_player::stop()
 {
+    wait_pending_stop();
+
     if( !is_open() )
         return;
 
     libvlc_media_player_stop( _mp );
 }
 
+void basic_player::stop_async()
+{
+    if( !is_open() )
+        return;
+
+    libvlc_media_player_t* mp = _mp;
+    libvlc_media_player_retain( mp );
+    const std::weak_ptr<owner_token> owner = _owner;
+    _pending_stop = reaper::instance().post( [mp, owner] () {
+        //media player could be closed and acquired by other owner meanwhile
+        if( const std::shared_ptr<owner_token> locked = owner.lock() )
+            libvlc_media_player_stop( mp );
+        libvlc_media_player_release( mp );
+    } );
+}
+
+bool basic_player::stop_pending() const
+{
+    return _pending_stop.valid() &&
+           _pending_stop.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready;
+}
+
+void basic_player::wait_pending_stop()
+{
+    if( _pending_stop.valid() ) {
+        _pending_stop.wait();
+        _pending_stop = std::shared_future<void>();
+    }
+}
+
 vlc::media basic_player::current_media()
+{
+    vlc::media media;
+    current_media( &media );
+    return media;
+}
+
+bool basic_player::current_media( vlc::media* out )
 {
     if( is_open() )
-        return vlc::media( libvlc_media_player_get_media( _mp ), false );
+        *out = vlc::media( libvlc_media_player_get_media( _mp ), false );
     else
-        return vlc::media();
+        *out = vlc::media();
+
+    return *out;
 }
 
 void basic_player::set_media( const vlc::media& media )
 {
+    wait_pending_stop();
+
     if( is_open() )
         libvlc_media_player_set_media( _mp, media.libvlc_media_t() );
 }
+
+void basic_player::set_media( vlc::media&& media )
+{
+    const vlc::media m( std::move( media ) );
+    set_media( m );
+}
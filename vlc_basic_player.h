@@ -25,6 +25,9 @@
 
 #pragma once
 
+#include <future>
+#include <memory>
+
 #include <vlc/vlc.h>
 
 #include "vlc_media.h"
@@ -39,6 +42,8 @@ namespace vlc
 
         bool open( libvlc_instance_t* inst );
         void close();
+        //media player is stopped and released on reaper thread
+        void close_async();
 
         void swap( basic_player* );
 
@@ -48,10 +53,19 @@ namespace vlc
         void pause();
         void togglePause();
         void stop();
+        //libvlc_media_player_stop is called on reaper thread,
+        //so state could be not changed yet right after return.
+        //play/stop/set_media wait until it is done
+        void stop_async();
+        bool stop_pending() const;
 
         void set_media( const vlc::media& );
+        //media player keeps own reference, so media is released right away
+        void set_media( vlc::media&& );
 
         vlc::media current_media();
+        //writes to caller's media, returns false (with out cleared) if there is no media
+        bool current_media( vlc::media* out );
 
         libvlc_state_t get_state();
 
@@ -62,8 +76,28 @@ namespace vlc
         libvlc_media_player_t* get_mp() const
             { return _mp; }
 
+        //media player will not be returned to media_player_pool on close.
+        //should be called if media player is set up directly through libvlc
+        //in a way pool can't reset (f.e. video/audio callbacks)
+        void disable_pool_reuse()
+            { _reusable = false; }
+
     private:
+        void wait_pending_stop();
+        //should be called when media player is given away (closed),
+        //jobs posted by stop_async will not touch it anymore
+        void release_owner();
+
+    private:
+        //identifies ownership of _mp: reaper jobs keep weak reference to it
+        //and skip their work if media player was closed meanwhile
+        //(and so could be acquired from media_player_pool by other owner)
+        struct owner_token {};
+
         libvlc_instance_t*     _libvlc_instance;
         libvlc_media_player_t* _mp;
+        bool                   _reusable;
+        std::shared_ptr<owner_token> _owner;
+        std::shared_future<void> _pending_stop;
     };
 };
@@ -0,0 +1,253 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "vlc_event_dispatcher.h"
+
+#include <cassert>
+
+#include "vlc_player.h"
+
+using namespace vlc;
+
+//libvlc_media_t from event payload,
+//it have to be retained while event is waiting in queue
+static libvlc_media_t* event_media( const libvlc_event_t* e )
+{
+    switch( e->type ) {
+    case libvlc_MediaPlayerMediaChanged:
+        return e->u.media_player_media_changed.new_media;
+    case libvlc_MediaListItemAdded:
+        return e->u.media_list_item_added.item;
+    case libvlc_MediaListWillAddItem:
+        return const_cast<libvlc_media_t*>( e->u.media_list_will_add_item.item );
+    case libvlc_MediaListItemDeleted:
+        return e->u.media_list_item_deleted.item;
+    case libvlc_MediaListWillDeleteItem:
+        return const_cast<libvlc_media_t*>( e->u.media_list_will_delete_item.item );
+    case libvlc_MediaListPlayerNextItemSet:
+        return e->u.media_list_player_next_item_set.item;
+    default:
+        return nullptr;
+    }
+}
+
+event_dispatcher::event_dispatcher( unsigned capacity,
+                                    dispatcher_overflow_e overflow )
+    : _overflow( overflow ), _queue( capacity ? capacity : 1 ),
+      _head( 0 ), _count( 0 ), _stopping( false ), _dispatching( nullptr ),
+      _max_depth( 0 ), _dispatched_count( 0 ), _dropped_count( 0 )
+{
+}
+
+event_dispatcher::~event_dispatcher()
+{
+    stop();
+}
+
+bool event_dispatcher::start()
+{
+    std::lock_guard<std::mutex> lock( _guard );
+
+    if( _thread.joinable() )
+        return true;
+
+    _stopping = false;
+    _thread = std::thread( &event_dispatcher::run, this );
+
+    return true;
+}
+
+void event_dispatcher::stop()
+{
+    std::unique_lock<std::mutex> lock( _guard );
+
+    if( !_thread.joinable() )
+        return;
+
+    assert( _thread.get_id() != std::this_thread::get_id() );
+
+    _stopping = true;
+    _not_empty.notify_one();
+    _not_full.notify_all();
+
+    lock.unlock();
+    _thread.join();
+    lock.lock();
+
+    while( _count )
+        pop_front();
+}
+
+bool event_dispatcher::is_running() const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+
+    return _thread.joinable() && !_stopping;
+}
+
+unsigned event_dispatcher::depth() const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+    return _count;
+}
+
+unsigned event_dispatcher::max_depth() const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+    return _max_depth;
+}
+
+uint64_t event_dispatcher::dispatched_count() const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+    return _dispatched_count;
+}
+
+uint64_t event_dispatcher::dropped_count() const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+    return _dropped_count;
+}
+
+void event_dispatcher::pop_front()
+{
+    assert( _count );
+
+    queued_event& q = _queue[_head];
+    if( q.media )
+        libvlc_media_release( q.media );
+
+    _head = ( _head + 1 ) % _queue.size();
+    --_count;
+}
+
+bool event_dispatcher::post( player_core* target, const libvlc_event_t* e )
+{
+    std::unique_lock<std::mutex> lock( _guard );
+
+    if( !_thread.joinable() || _stopping )
+        return false;
+
+    const unsigned capacity = static_cast<unsigned>( _queue.size() );
+    if( _count == capacity ) {
+        switch( _overflow ) {
+        case dispatcher_overflow_e::drop_newest:
+            ++_dropped_count;
+            return true;
+        case dispatcher_overflow_e::drop_oldest:
+            pop_front();
+            ++_dropped_count;
+            break;
+        case dispatcher_overflow_e::block:
+            //event was generated by callback itself (f.e. by player.stop()),
+            //waiting will never end, so deliver it in place
+            if( _thread.get_id() == std::this_thread::get_id() )
+                return false;
+
+            _not_full.wait( lock, [this, capacity] () {
+                return _count < capacity || _stopping;
+            } );
+            if( _stopping )
+                return false;
+            break;
+        }
+    }
+
+    queued_event& q = _queue[( _head + _count ) % capacity];
+    q.target = target;
+    q.event = *e;
+    q.media = event_media( e );
+    if( q.media )
+        libvlc_media_retain( q.media );
+
+    ++_count;
+    if( _count > _max_depth )
+        _max_depth = _count;
+
+    _not_empty.notify_one();
+
+    return true;
+}
+
+void event_dispatcher::cancel( player_core* target )
+{
+    std::unique_lock<std::mutex> lock( _guard );
+
+    const unsigned capacity = static_cast<unsigned>( _queue.size() );
+    for( unsigned i = 0; i < _count; ++i ) {
+        queued_event& q = _queue[( _head + i ) % capacity];
+        if( q.target == target )
+            q.target = nullptr;
+    }
+
+    if( _thread.get_id() == std::this_thread::get_id() )
+        return;
+
+    _idle.wait( lock, [this, target] () {
+        return _dispatching != target;
+    } );
+}
+
+void event_dispatcher::run()
+{
+    std::unique_lock<std::mutex> lock( _guard );
+
+    for( ;; ) {
+        _not_empty.wait( lock, [this] () {
+            return _count || _stopping;
+        } );
+
+        if( _stopping )
+            break;
+
+        queued_event& q = _queue[_head];
+        player_core* target = q.target;
+        const libvlc_event_t event = q.event;
+        libvlc_media_t* media = q.media;
+        q.media = nullptr;
+        pop_front();
+
+        _not_full.notify_one();
+
+        if( !target ) {
+            if( media )
+                libvlc_media_release( media );
+            continue;
+        }
+
+        _dispatching = target;
+        lock.unlock();
+
+        target->event( &event );
+
+        if( media )
+            libvlc_media_release( media );
+
+        lock.lock();
+        _dispatching = nullptr;
+        ++_dispatched_count;
+        _idle.notify_all();
+    }
+}
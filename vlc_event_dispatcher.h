@@ -0,0 +1,116 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <vlc/vlc.h>
+
+namespace vlc
+{
+    class player_core;
+
+    enum class dispatcher_overflow_e
+    {
+        drop_newest, //incoming event is dropped
+        drop_oldest, //oldest queued event is dropped
+        block,       //libvlc thread waits for free space in queue
+    };
+
+    //delivers media player events to player_core callbacks
+    //on own thread instead of libvlc internal thread,
+    //so slow callback doesn't delay libvlc.
+    //Can be shared between any number of player_core's (see player_core::set_event_dispatcher)
+    class event_dispatcher
+    {
+    public:
+        event_dispatcher( unsigned capacity = 256,
+                          dispatcher_overflow_e overflow = dispatcher_overflow_e::drop_oldest );
+        ~event_dispatcher();
+
+        bool start();
+        //queued events are discarded
+        void stop();
+
+        bool is_running() const;
+
+        unsigned capacity() const
+            { return static_cast<unsigned>( _queue.size() ); }
+
+        //count of events waiting for delivery
+        unsigned depth() const;
+        unsigned max_depth() const;
+        uint64_t dispatched_count() const;
+        uint64_t dropped_count() const;
+
+    private:
+        friend class player_core;
+
+        //returns false if event should be delivered synchronously
+        bool post( player_core*, const libvlc_event_t* );
+        //forget all queued events for player
+        //and wait while event is delivered to it right now
+        void cancel( player_core* );
+
+        void run();
+        //should be called with _guard locked
+        void pop_front();
+
+    private:
+        struct queued_event
+        {
+            player_core* target;
+            libvlc_event_t event;
+            //retained media from event payload, if any
+            libvlc_media_t* media;
+        };
+
+    private:
+        const dispatcher_overflow_e _overflow;
+
+        mutable std::mutex _guard;
+        std::condition_variable _not_empty;
+        std::condition_variable _not_full;
+        std::condition_variable _idle;
+
+        std::vector<queued_event> _queue;
+        unsigned _head;
+        unsigned _count;
+
+        std::thread _thread;
+        bool _stopping;
+        player_core* _dispatching;
+
+        unsigned _max_depth;
+        uint64_t _dispatched_count;
+        uint64_t _dropped_count;
+    };
+}
@@ -0,0 +1,303 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "vlc_event_trace.h"
+
+#include <cstring>
+
+#include <thread>
+
+#include "vlc_player.h"
+
+using namespace vlc;
+
+static const char TRACE_MAGIC[4] = { 'V', 'L', 'E', 'T' };
+static const uint32_t TRACE_VERSION = 1;
+
+enum {
+    TRACE_RECORD_SIZE = sizeof( uint64_t ) + sizeof( int32_t ) + sizeof( int64_t )
+};
+
+static int64_t float_payload( float f )
+{
+    int32_t bits;
+    memcpy( &bits, &f, sizeof( bits ) );
+    return bits;
+}
+
+static float payload_float( int64_t payload )
+{
+    const int32_t bits = static_cast<int32_t>( payload );
+    float f;
+    memcpy( &f, &bits, sizeof( f ) );
+    return f;
+}
+
+static int64_t event_payload( const libvlc_event_t* e )
+{
+    switch( e->type ) {
+    case libvlc_MediaPlayerBuffering:
+        return float_payload( e->u.media_player_buffering.new_cache );
+    case libvlc_MediaPlayerPositionChanged:
+        return float_payload( e->u.media_player_position_changed.new_position );
+    case libvlc_MediaPlayerTimeChanged:
+        return e->u.media_player_time_changed.new_time;
+    case libvlc_MediaPlayerLengthChanged:
+        return e->u.media_player_length_changed.new_length;
+    case libvlc_MediaPlayerSeekableChanged:
+        return e->u.media_player_seekable_changed.new_seekable;
+    case libvlc_MediaPlayerPausableChanged:
+        return e->u.media_player_pausable_changed.new_pausable;
+    case libvlc_MediaPlayerTitleChanged:
+        return e->u.media_player_title_changed.new_title;
+    case libvlc_MediaPlayerVout:
+        return e->u.media_player_vout.new_count;
+    case libvlc_MediaListItemAdded:
+        return e->u.media_list_item_added.index;
+    case libvlc_MediaListWillAddItem:
+        return e->u.media_list_will_add_item.index;
+    case libvlc_MediaListItemDeleted:
+        return e->u.media_list_item_deleted.index;
+    case libvlc_MediaListWillDeleteItem:
+        return e->u.media_list_will_delete_item.index;
+    default:
+        return 0;
+    }
+}
+
+static void set_event_payload( libvlc_event_t* e, int64_t payload )
+{
+    switch( e->type ) {
+    case libvlc_MediaPlayerBuffering:
+        e->u.media_player_buffering.new_cache = payload_float( payload );
+        break;
+    case libvlc_MediaPlayerPositionChanged:
+        e->u.media_player_position_changed.new_position = payload_float( payload );
+        break;
+    case libvlc_MediaPlayerTimeChanged:
+        e->u.media_player_time_changed.new_time = payload;
+        break;
+    case libvlc_MediaPlayerLengthChanged:
+        e->u.media_player_length_changed.new_length = payload;
+        break;
+    case libvlc_MediaPlayerSeekableChanged:
+        e->u.media_player_seekable_changed.new_seekable = static_cast<int>( payload );
+        break;
+    case libvlc_MediaPlayerPausableChanged:
+        e->u.media_player_pausable_changed.new_pausable = static_cast<int>( payload );
+        break;
+    case libvlc_MediaPlayerTitleChanged:
+        e->u.media_player_title_changed.new_title = static_cast<int>( payload );
+        break;
+    case libvlc_MediaPlayerVout:
+        e->u.media_player_vout.new_count = static_cast<int>( payload );
+        break;
+    case libvlc_MediaListItemAdded:
+        e->u.media_list_item_added.index = static_cast<int>( payload );
+        break;
+    case libvlc_MediaListWillAddItem:
+        e->u.media_list_will_add_item.index = static_cast<int>( payload );
+        break;
+    case libvlc_MediaListItemDeleted:
+        e->u.media_list_item_deleted.index = static_cast<int>( payload );
+        break;
+    case libvlc_MediaListWillDeleteItem:
+        e->u.media_list_will_delete_item.index = static_cast<int>( payload );
+        break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class vlc::event_trace_recorder
+////////////////////////////////////////////////////////////////////////////////
+event_trace_recorder::event_trace_recorder()
+    : _file( nullptr ), _recorded_count( 0 )
+{
+}
+
+event_trace_recorder::~event_trace_recorder()
+{
+    close();
+}
+
+bool event_trace_recorder::open( const std::string& file_name )
+{
+    close();
+
+    std::lock_guard<std::mutex> lock( _guard );
+
+    _file = fopen( file_name.c_str(), "wb" );
+    if( !_file )
+        return false;
+
+    if( fwrite( TRACE_MAGIC, sizeof( TRACE_MAGIC ), 1, _file ) != 1 ||
+        fwrite( &TRACE_VERSION, sizeof( TRACE_VERSION ), 1, _file ) != 1 )
+    {
+        fclose( _file );
+        _file = nullptr;
+        return false;
+    }
+
+    _start = clock::now();
+    _recorded_count = 0;
+
+    return true;
+}
+
+void event_trace_recorder::close()
+{
+    std::lock_guard<std::mutex> lock( _guard );
+
+    if( _file ) {
+        fclose( _file );
+        _file = nullptr;
+    }
+}
+
+bool event_trace_recorder::is_open() const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+    return _file != nullptr;
+}
+
+uint64_t event_trace_recorder::recorded_count() const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+    return _recorded_count;
+}
+
+void event_trace_recorder::record( const libvlc_event_t* e )
+{
+    const clock::time_point now = clock::now();
+
+    std::lock_guard<std::mutex> lock( _guard );
+
+    if( !_file )
+        return;
+
+    const uint64_t time =
+        std::chrono::duration_cast<std::chrono::microseconds>( now - _start ).count();
+    const int32_t type = e->type;
+    const int64_t payload = event_payload( e );
+
+    char record[TRACE_RECORD_SIZE];
+    memcpy( record, &time, sizeof( time ) );
+    memcpy( record + sizeof( time ), &type, sizeof( type ) );
+    memcpy( record + sizeof( time ) + sizeof( type ), &payload, sizeof( payload ) );
+
+    if( fwrite( record, sizeof( record ), 1, _file ) == 1 )
+        ++_recorded_count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class vlc::event_trace_player
+////////////////////////////////////////////////////////////////////////////////
+event_trace_player::event_trace_player()
+    : _file( nullptr )
+{
+}
+
+event_trace_player::~event_trace_player()
+{
+    close();
+}
+
+bool event_trace_player::open( const std::string& file_name )
+{
+    close();
+
+    _file = fopen( file_name.c_str(), "rb" );
+    if( !_file )
+        return false;
+
+    char magic[sizeof( TRACE_MAGIC )];
+    uint32_t version = 0;
+    if( fread( magic, sizeof( magic ), 1, _file ) != 1 ||
+        fread( &version, sizeof( version ), 1, _file ) != 1 ||
+        memcmp( magic, TRACE_MAGIC, sizeof( magic ) ) != 0 ||
+        version != TRACE_VERSION )
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void event_trace_player::close()
+{
+    if( _file ) {
+        fclose( _file );
+        _file = nullptr;
+    }
+}
+
+unsigned event_trace_player::replay( player_core* target, double speed /*= 1.*/ )
+{
+    if( !_file || !target )
+        return 0;
+
+    const long data_start = sizeof( TRACE_MAGIC ) + sizeof( TRACE_VERSION );
+    if( fseek( _file, data_start, SEEK_SET ) != 0 )
+        return 0;
+
+    event_trace_recorder* recorder = target->_event_recorder.exchange( nullptr );
+
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point start = clock::now();
+
+    unsigned count = 0;
+    char record[TRACE_RECORD_SIZE];
+    while( fread( record, sizeof( record ), 1, _file ) == 1 ) {
+        uint64_t time;
+        int32_t type;
+        int64_t payload;
+        memcpy( &time, record, sizeof( time ) );
+        memcpy( &type, record + sizeof( time ), sizeof( type ) );
+        memcpy( &payload, record + sizeof( time ) + sizeof( type ), sizeof( payload ) );
+
+        if( speed > 0 ) {
+            std::this_thread::sleep_until(
+                start + std::chrono::microseconds(
+                    static_cast<int64_t>( static_cast<double>( time ) / speed ) ) );
+        }
+
+        libvlc_event_t e;
+        memset( &e, 0, sizeof( e ) );
+        e.type = type;
+        e.p_obj = target->get_mp();
+        set_event_payload( &e, payload );
+
+        player_core::event_proxy( &e, target );
+
+        ++count;
+    }
+
+    //restore recorder, unless other one was set meanwhile
+    event_trace_recorder* expected = nullptr;
+    target->_event_recorder.compare_exchange_strong( expected, recorder );
+
+    return count;
+}
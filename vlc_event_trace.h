@@ -0,0 +1,100 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <chrono>
+#include <mutex>
+
+#include <vlc/vlc.h>
+
+namespace vlc
+{
+    class player_core;
+
+    //Trace file format (native byte order):
+    //  header: "VLET" magic, uint32 version
+    //  record: uint64 microseconds since recording start,
+    //          int32 event type,
+    //          int64 payload (time, length, int or float value of event, if any)
+    //Pointers from event payload (media, file names) are not recorded.
+
+    //writes every event player_core receives from libvlc to trace file
+    //(see player_core::set_event_recorder)
+    class event_trace_recorder
+    {
+    public:
+        event_trace_recorder();
+        ~event_trace_recorder();
+
+        bool open( const std::string& file_name );
+        void close();
+
+        bool is_open() const;
+
+        uint64_t recorded_count() const;
+
+        //could be called from any thread
+        void record( const libvlc_event_t* );
+
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        mutable std::mutex _guard;
+        FILE* _file;
+        clock::time_point _start;
+        uint64_t _recorded_count;
+    };
+
+    //feeds events from trace file to player_core callbacks
+    //(through event dispatcher if player has one)
+    class event_trace_player
+    {
+    public:
+        event_trace_player();
+        ~event_trace_player();
+
+        bool open( const std::string& file_name );
+        void close();
+
+        bool is_open() const
+            { return _file != nullptr; }
+
+        //speed: 1 - original timing, 2 - twice faster, etc.,
+        //       0 - as fast as possible.
+        //returns count of replayed events.
+        //MediaChanged and media list events are replayed with null media.
+        //target event recorder (if any) is detached while replaying,
+        //so replayed events are not recorded again.
+        unsigned replay( player_core* target, double speed = 1. );
+
+    private:
+        FILE* _file;
+    };
+}
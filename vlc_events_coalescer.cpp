@@ -0,0 +1,228 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "vlc_events_coalescer.h"
+
+using namespace vlc;
+
+media_player_events_coalescer::media_player_events_coalescer( media_player_events_callback* target,
+                                                              unsigned max_rate )
+    : _target( target ), _merged_count( 0 ), _delivered_count( 0 ),
+      _has_deadline( false ), _stopping( false )
+{
+    for( coalesced_event& c: _coalesced ) {
+        c.pending = false;
+    }
+
+    set_max_rate( max_rate );
+}
+
+media_player_events_coalescer::~media_player_events_coalescer()
+{
+    {
+        std::lock_guard<std::mutex> lock( _guard );
+        _stopping = true;
+        _deadline_changed.notify_one();
+    }
+
+    if( !_thread.joinable() )
+        return;
+
+    //could be destroyed from target callback called from own thread
+    if( _thread.get_id() == std::this_thread::get_id() )
+        _thread.detach();
+    else
+        _thread.join();
+}
+
+unsigned media_player_events_coalescer::max_rate() const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+
+    if( _min_interval == clock::duration::zero() )
+        return 0;
+
+    return static_cast<unsigned>( std::chrono::seconds( 1 ) / _min_interval );
+}
+
+void media_player_events_coalescer::set_max_rate( unsigned max_rate )
+{
+    std::lock_guard<std::mutex> lock( _guard );
+
+    if( max_rate )
+        _min_interval = std::chrono::duration_cast<clock::duration>( std::chrono::seconds( 1 ) ) / max_rate;
+    else
+        _min_interval = clock::duration::zero();
+}
+
+uint64_t media_player_events_coalescer::merged_count() const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+    return _merged_count;
+}
+
+uint64_t media_player_events_coalescer::delivered_count() const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+    return _delivered_count;
+}
+
+int media_player_events_coalescer::coalesced_index( libvlc_event_type_t type )
+{
+    switch( type ) {
+    case libvlc_MediaPlayerTimeChanged:
+        return coalesced_time;
+    case libvlc_MediaPlayerPositionChanged:
+        return coalesced_position;
+    default:
+        return -1;
+    }
+}
+
+void media_player_events_coalescer::deliver( const libvlc_event_t* e )
+{
+    if( _target )
+        _target->media_player_event( e );
+}
+
+unsigned media_player_events_coalescer::take_pending( bool overdue_only, libvlc_event_t* out )
+{
+    unsigned count = 0;
+
+    const clock::time_point now = clock::now();
+    for( coalesced_event& c: _coalesced ) {
+        if( !c.pending )
+            continue;
+
+        if( overdue_only && now - c.last_delivery < _min_interval ) {
+            set_deadline( c.last_delivery + _min_interval );
+            continue;
+        }
+
+        out[count++] = c.event;
+        c.pending = false;
+        c.last_delivery = now;
+        ++_delivered_count;
+    }
+
+    return count;
+}
+
+void media_player_events_coalescer::set_deadline( clock::time_point deadline )
+{
+    if( _has_deadline && _deadline <= deadline )
+        return;
+
+    _has_deadline = true;
+    _deadline = deadline;
+
+    if( !_thread.joinable() )
+        _thread = std::thread( &media_player_events_coalescer::run, this );
+    else
+        _deadline_changed.notify_one();
+}
+
+void media_player_events_coalescer::run()
+{
+    std::unique_lock<std::mutex> lock( _guard );
+
+    for( ;; ) {
+        if( _stopping )
+            break;
+
+        if( !_has_deadline ) {
+            _deadline_changed.wait( lock );
+            continue;
+        }
+
+        if( clock::now() < _deadline ) {
+            _deadline_changed.wait_until( lock, _deadline );
+            continue;
+        }
+
+        //events delivered meanwhile set no deadline,
+        //so it's recalculated from ones still pending
+        _has_deadline = false;
+
+        libvlc_event_t pending[coalesced_count];
+        const unsigned pending_count = take_pending( true, pending );
+
+        lock.unlock();
+        for( unsigned i = 0; i < pending_count; ++i )
+            deliver( &pending[i] );
+        lock.lock();
+    }
+}
+
+void media_player_events_coalescer::flush()
+{
+    libvlc_event_t pending[coalesced_count];
+    unsigned pending_count;
+
+    {
+        std::lock_guard<std::mutex> lock( _guard );
+        pending_count = take_pending( false, pending );
+    }
+
+    for( unsigned i = 0; i < pending_count; ++i )
+        deliver( &pending[i] );
+}
+
+void media_player_events_coalescer::media_player_event( const libvlc_event_t* e )
+{
+    const int idx = coalesced_index( e->type );
+    if( idx < 0 ) {
+        //state changes etc. should not overtake time/position changes
+        flush();
+        deliver( e );
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( _guard );
+
+        coalesced_event& c = _coalesced[idx];
+
+        //any pending value is superseded by this one
+        if( c.pending )
+            ++_merged_count;
+
+        const clock::time_point now = clock::now();
+        if( _min_interval != clock::duration::zero() &&
+            now - c.last_delivery < _min_interval )
+        {
+            c.event = *e;
+            c.pending = true;
+            set_deadline( c.last_delivery + _min_interval );
+            return;
+        }
+
+        c.pending = false;
+        c.last_delivery = now;
+        ++_delivered_count;
+    }
+
+    deliver( e );
+}
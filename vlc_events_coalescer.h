@@ -0,0 +1,112 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "vlc_player.h"
+
+namespace vlc
+{
+    //sits between player_core and some media_player_events_callback
+    //and merges high rate libvlc_MediaPlayerTimeChanged/libvlc_MediaPlayerPositionChanged
+    //events, so target gets not more than max_rate of them per second
+    //(only latest value is delivered, the rest are counted as merged).
+    //All other events are passed as is, but pending merged events are delivered before them.
+    //Pending value not superseded in 1/max_rate seconds is delivered
+    //from coalescer own thread (started on first merged event),
+    //so target should accept events from it too.
+    //Usage: player.register_callback( &coalescer, mask );
+    //(and unregister it before coalescer is destroyed)
+    class media_player_events_coalescer : public media_player_events_callback
+    {
+    public:
+        //0 - deliver all events
+        media_player_events_coalescer( media_player_events_callback* target,
+                                       unsigned max_rate );
+        //waits while pending events are delivered from own thread
+        ~media_player_events_coalescer();
+
+        unsigned max_rate() const;
+        void set_max_rate( unsigned );
+
+        //deliver pending merged events right now (from the calling thread)
+        void flush();
+
+        uint64_t merged_count() const;
+        uint64_t delivered_count() const;
+
+        void media_player_event( const libvlc_event_t* e ) override;
+
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        enum coalesced_e {
+            coalesced_time,
+            coalesced_position,
+            coalesced_count
+        };
+
+        struct coalesced_event
+        {
+            libvlc_event_t event;
+            bool pending;
+            clock::time_point last_delivery;
+        };
+
+        static int coalesced_index( libvlc_event_type_t );
+
+        //should be called with _guard locked,
+        //if overdue_only, takes only events waiting not less than _min_interval,
+        //returns count of taken events
+        unsigned take_pending( bool overdue_only, libvlc_event_t* out );
+        //should be called with _guard locked
+        void set_deadline( clock::time_point );
+        void deliver( const libvlc_event_t* e );
+        //delivers pending events on deadline
+        void run();
+
+    private:
+        media_player_events_callback *const _target;
+
+        mutable std::mutex _guard;
+        clock::duration _min_interval;
+        coalesced_event _coalesced[coalesced_count];
+        uint64_t _merged_count;
+        uint64_t _delivered_count;
+
+        std::thread _thread;
+        std::condition_variable _deadline_changed;
+        bool _has_deadline;
+        clock::time_point _deadline;
+        bool _stopping;
+    };
+}
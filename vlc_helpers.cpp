@@ -49,3 +49,167 @@ int vlc::track_id_2_track_idx( const libvlc_track_description_t *const tracks, i
 
     return -1;
 }
+
+void vlc::copy_player_settings( libvlc_media_player_t* from, libvlc_media_player_t* to )
+{
+    libvlc_media_player_set_rate( to, libvlc_media_player_get_rate( from ) );
+
+    //volume and mute are unknown while there is no audio output
+    const int volume = libvlc_audio_get_volume( from );
+    if( volume >= 0 )
+        libvlc_audio_set_volume( to, volume );
+    const int mute = libvlc_audio_get_mute( from );
+    if( mute >= 0 )
+        libvlc_audio_set_mute( to, mute );
+
+    libvlc_audio_set_delay( to, libvlc_audio_get_delay( from ) );
+    libvlc_video_set_spu_delay( to, libvlc_video_get_spu_delay( from ) );
+
+    char* aspect = libvlc_video_get_aspect_ratio( from );
+    libvlc_video_set_aspect_ratio( to, aspect );
+    libvlc_free( aspect );
+
+    libvlc_video_set_scale( to, libvlc_video_get_scale( from ) );
+
+    char* crop = libvlc_video_get_crop_geometry( from );
+    libvlc_video_set_crop_geometry( to, crop );
+    libvlc_free( crop );
+
+    static const libvlc_video_adjust_option_t adjust_float_options[] = {
+        libvlc_adjust_Contrast, libvlc_adjust_Brightness,
+        libvlc_adjust_Saturation, libvlc_adjust_Gamma,
+    };
+    for( libvlc_video_adjust_option_t o: adjust_float_options )
+        libvlc_video_set_adjust_float( to, o, libvlc_video_get_adjust_float( from, o ) );
+    libvlc_video_set_adjust_int( to, libvlc_adjust_Hue,
+                                 libvlc_video_get_adjust_int( from, libvlc_adjust_Hue ) );
+    libvlc_video_set_adjust_int( to, libvlc_adjust_Enable,
+                                 libvlc_video_get_adjust_int( from, libvlc_adjust_Enable ) );
+
+    char* marquee_text = libvlc_video_get_marquee_string( from, libvlc_marquee_Text );
+    libvlc_video_set_marquee_string( to, libvlc_marquee_Text, marquee_text );
+    libvlc_free( marquee_text );
+
+    //enabled last, when marquee is set up already
+    static const libvlc_video_marquee_option_t marquee_options[] = {
+        libvlc_marquee_Color, libvlc_marquee_Opacity, libvlc_marquee_Position,
+        libvlc_marquee_Refresh, libvlc_marquee_Size, libvlc_marquee_Timeout,
+        libvlc_marquee_X, libvlc_marquee_Y, libvlc_marquee_Enable,
+    };
+    for( libvlc_video_marquee_option_t o: marquee_options )
+        libvlc_video_set_marquee_int( to, o, libvlc_video_get_marquee_int( from, o ) );
+}
+
+using namespace vlc;
+
+tracks_cache::tracks_cache( fetch_t fetch )
+    : _fetch( fetch ), _enabled( false ), _generation( 1 ), _tracks_generation( 0 )
+{
+}
+
+void tracks_cache::set_enabled( bool enable )
+{
+    _enabled = enable;
+    invalidate();
+}
+
+bool tracks_cache::update( libvlc_media_player_t* mp )
+{
+    if( _enabled && _generation == _tracks_generation )
+        return false;
+
+    fetch( mp );
+
+    return true;
+}
+
+void tracks_cache::fetch( libvlc_media_player_t* mp )
+{
+    //if invalidated while fetching, will be fetched again next time
+    const unsigned generation = _generation;
+
+    _tracks.clear();
+
+    if( libvlc_track_description_t* tracks = _fetch( mp ) ) {
+        for( const libvlc_track_description_t* t = tracks; t; t = t->p_next ) {
+            track_info info;
+            info.id = t->i_id;
+            if( t->psz_name )
+                info.name = t->psz_name;
+            _tracks.push_back( info );
+        }
+
+        libvlc_track_description_list_release( tracks );
+    }
+
+    _tracks_generation = generation;
+}
+
+bool tracks_cache::has_idx( libvlc_media_player_t* mp, int idx )
+{
+    if( idx < 0 )
+        return false;
+
+    //tracks could change without any event cache is invalidated on
+    if( !update( mp ) && unsigned( idx ) >= _tracks.size() )
+        fetch( mp );
+
+    return unsigned( idx ) < _tracks.size();
+}
+
+int tracks_cache::find_id( int id ) const
+{
+    for( unsigned idx = 0; idx < _tracks.size(); ++idx ) {
+        if( _tracks[idx].id == id )
+            return idx;
+    }
+
+    return -1;
+}
+
+unsigned tracks_cache::count( libvlc_media_player_t* mp )
+{
+    std::lock_guard<std::mutex> lock( _guard );
+    update( mp );
+
+    return static_cast<unsigned>( _tracks.size() );
+}
+
+bool tracks_cache::idx_2_id( libvlc_media_player_t* mp, int idx, int* id )
+{
+    std::lock_guard<std::mutex> lock( _guard );
+
+    if( !has_idx( mp, idx ) )
+        return false;
+
+    *id = _tracks[idx].id;
+
+    return true;
+}
+
+int tracks_cache::id_2_idx( libvlc_media_player_t* mp, int id )
+{
+    if( id < 0 )
+        return -1;
+
+    std::lock_guard<std::mutex> lock( _guard );
+
+    const bool fetched = update( mp );
+    int idx = find_id( id );
+    if( idx < 0 && !fetched ) {
+        fetch( mp );
+        idx = find_id( id );
+    }
+
+    return idx;
+}
+
+std::string tracks_cache::name( libvlc_media_player_t* mp, int idx )
+{
+    std::lock_guard<std::mutex> lock( _guard );
+
+    if( !has_idx( mp, idx ) )
+        return std::string();
+
+    return _tracks[idx].name;
+}
@@ -25,10 +25,74 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
 #include <vlc/vlc.h>
 
 namespace vlc
 {
     int track_idx_2_track_id( const libvlc_track_description_t *const, int );
     int track_id_2_track_idx( const libvlc_track_description_t *const, int );
+
+    //copies media player settings which media_player_pool resets
+    //(except ones libvlc can't read back: deinterlace mode, logo, key/mouse input)
+    void copy_player_settings( libvlc_media_player_t* from, libvlc_media_player_t* to );
+
+    struct track_info
+    {
+        int id;
+        std::string name;
+    };
+
+    //track descriptions of media player. Track index is position in table.
+    //If enabled, table is fetched from libvlc on first query after invalidate
+    //(owner should invalidate it when tracks could change),
+    //otherwise it's fetched on every query.
+    //Table is fetched again if index or id is not found in it.
+    class tracks_cache
+    {
+    public:
+        typedef libvlc_track_description_t* ( *fetch_t )( libvlc_media_player_t* );
+
+        explicit tracks_cache( fetch_t fetch );
+
+        tracks_cache( const tracks_cache& ) = delete;
+        tracks_cache& operator= ( const tracks_cache& ) = delete;
+
+        void set_enabled( bool enable );
+
+        //could be called from any thread (f.e. from libvlc events)
+        void invalidate()
+            { ++_generation; }
+
+        unsigned count( libvlc_media_player_t* );
+        //false if there is no such track
+        bool idx_2_id( libvlc_media_player_t*, int idx, int* id );
+        //-1 if there is no such track
+        int id_2_idx( libvlc_media_player_t*, int id );
+        std::string name( libvlc_media_player_t*, int idx );
+
+    private:
+        //following should be called with _guard locked
+        //returns false if table is up to date and was not fetched
+        bool update( libvlc_media_player_t* );
+        void fetch( libvlc_media_player_t* );
+        //fetches table again if idx is out of stale table
+        bool has_idx( libvlc_media_player_t*, int idx );
+        int find_id( int id ) const;
+
+    private:
+        const fetch_t _fetch;
+
+        std::atomic<bool> _enabled;
+        std::atomic<unsigned> _generation;
+
+        std::mutex _guard;
+        //generation _tracks were fetched at
+        unsigned _tracks_generation;
+        std::vector<track_info> _tracks;
+    };
 };
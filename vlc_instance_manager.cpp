@@ -0,0 +1,193 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "vlc_instance_manager.h"
+
+#include <cassert>
+
+using namespace vlc;
+
+instance_manager::instance_manager( int argc, const char* const* argv,
+                                    unsigned shard_count )
+    : _release_idle( false )
+{
+    for( int i = 0; i < argc; ++i )
+        _args.push_back( argv[i] );
+
+    shard s = { nullptr, 0, false };
+    _shards.assign( shard_count ? shard_count : 1, s );
+}
+
+instance_manager::~instance_manager()
+{
+    for( shard& s: _shards ) {
+        assert( !s.load && "all players should be closed before instance_manager destruction" );
+        if( s.instance ) {
+            libvlc_release( s.instance );
+            s.instance = nullptr;
+        }
+    }
+}
+
+libvlc_instance_t* instance_manager::create_instance() const
+{
+    std::vector<const char*> argv;
+    argv.reserve( _args.size() );
+    for( const std::string& arg: _args )
+        argv.push_back( arg.c_str() );
+
+    return libvlc_new( static_cast<int>( argv.size() ),
+                       argv.empty() ? nullptr : &argv[0] );
+}
+
+libvlc_instance_t* instance_manager::acquire()
+{
+    std::unique_lock<std::mutex> lock( _guard );
+
+    //prefer already created instances on equal load
+    shard* target = &_shards[0];
+    for( shard& s: _shards ) {
+        const bool created = s.instance || s.creating;
+        const bool target_created = target->instance || target->creating;
+        if( s.load < target->load ||
+            ( s.load == target->load && created && !target_created ) )
+        {
+            target = &s;
+        }
+    }
+
+    //load is taken in advance, so concurrent acquire
+    //will not pick the same shard while it's instance is created
+    ++target->load;
+
+    if( !target->instance && !target->creating ) {
+        target->creating = true;
+
+        //libvlc_new loads plugins, it's too slow to do it with _guard locked
+        lock.unlock();
+        libvlc_instance_t* inst = create_instance();
+        lock.lock();
+
+        target->instance = inst;
+        target->creating = false;
+        _created.notify_all();
+    } else {
+        _created.wait( lock, [target] () { return !target->creating; } );
+    }
+
+    if( !target->instance ) {
+        --target->load;
+        return nullptr;
+    }
+
+    return target->instance;
+}
+
+void instance_manager::release( libvlc_instance_t* inst )
+{
+    if( !inst )
+        return;
+
+    libvlc_instance_t* idle_instance = nullptr;
+    {
+        std::lock_guard<std::mutex> lock( _guard );
+
+        shard* owner = nullptr;
+        for( shard& s: _shards ) {
+            if( s.instance == inst ) {
+                owner = &s;
+                break;
+            }
+        }
+
+        assert( owner && "instance doesn't belong to instance_manager" );
+        if( !owner )
+            return;
+
+        assert( owner->load );
+        if( owner->load && 0 == --owner->load && _release_idle ) {
+            idle_instance = owner->instance;
+            owner->instance = nullptr;
+        }
+    }
+
+    //media players still alive keep own reference to instance
+    if( idle_instance )
+        libvlc_release( idle_instance );
+}
+
+void instance_manager::set_release_idle( bool enable )
+{
+    std::vector<libvlc_instance_t*> idle_instances;
+    {
+        std::lock_guard<std::mutex> lock( _guard );
+
+        _release_idle = enable;
+        if( !enable )
+            return;
+
+        for( shard& s: _shards ) {
+            if( s.instance && !s.load ) {
+                idle_instances.push_back( s.instance );
+                s.instance = nullptr;
+            }
+        }
+    }
+
+    for( libvlc_instance_t* inst: idle_instances )
+        libvlc_release( inst );
+}
+
+unsigned instance_manager::shard_load( unsigned shard ) const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+
+    if( shard >= _shards.size() )
+        return 0;
+
+    return _shards[shard].load;
+}
+
+libvlc_instance_t* instance_manager::shard_instance( unsigned shard ) const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+
+    if( shard >= _shards.size() )
+        return nullptr;
+
+    return _shards[shard].instance;
+}
+
+int instance_manager::find_shard( libvlc_instance_t* inst ) const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+
+    for( unsigned i = 0; i < _shards.size(); ++i ) {
+        if( inst && _shards[i].instance == inst )
+            return static_cast<int>( i );
+    }
+
+    return -1;
+}
@@ -0,0 +1,91 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include <vlc/vlc.h>
+
+namespace vlc
+{
+    //spreads players across several libvlc instances (shards)
+    //created with the same arguments, since libvlc instance wide locks
+    //become bottleneck when there are many players on one instance.
+    //Shard instance is created on first use and kept until manager
+    //destruction (so media_player_pool of it stays useful),
+    //unless set_release_idle( true ) was called.
+    //Manager should outlive all players opened with it.
+    class instance_manager
+    {
+    public:
+        instance_manager( int argc, const char* const* argv,
+                          unsigned shard_count = 1 );
+        ~instance_manager();
+
+        instance_manager( const instance_manager& ) = delete;
+        instance_manager& operator= ( const instance_manager& ) = delete;
+
+        //instance of least loaded shard, 0 on error.
+        //every acquire should be paired with release
+        libvlc_instance_t* acquire();
+        void release( libvlc_instance_t* );
+
+        //if enabled, shard instance is released when last player using it
+        //is closed (and created again on next acquire)
+        void set_release_idle( bool enable );
+
+        unsigned shard_count() const
+            { return static_cast<unsigned>( _shards.size() ); }
+        //count of players on shard
+        unsigned shard_load( unsigned shard ) const;
+        //0 if shard instance is not created yet
+        libvlc_instance_t* shard_instance( unsigned shard ) const;
+        //-1 if inst doesn't belong to any shard
+        int find_shard( libvlc_instance_t* inst ) const;
+
+    private:
+        struct shard
+        {
+            libvlc_instance_t* instance;
+            unsigned load;
+            //instance is being created by one of acquire (without _guard locked)
+            bool creating;
+        };
+
+        libvlc_instance_t* create_instance() const;
+
+    private:
+        std::vector<std::string> _args;
+
+        mutable std::mutex _guard;
+        std::condition_variable _created;
+        std::vector<shard> _shards;
+        bool _release_idle;
+    };
+}
@@ -72,6 +72,12 @@ media::media( const media& other )
         libvlc_media_retain( m_media );
 }
 
+media::media( media&& other ) noexcept
+    : m_media( other.m_media )
+{
+    other.m_media = nullptr;
+}
+
 media::~media()
 {
     release_media();
@@ -87,26 +93,40 @@ void media::release_media()
 
 media& media::operator= ( const media& m )
 {
+    //retain first, since m could be *this
+    ::libvlc_media_t* new_media = m.m_media;
+    if( new_media )
+        libvlc_media_retain( new_media );
+
     release_media();
+    m_media = new_media;
 
-    m_media = m.m_media;
-    if( m_media )
-        libvlc_media_retain( m_media );
+    return *this;
+}
+
+media& media::operator= ( media&& m ) noexcept
+{
+    if( this != &m ) {
+        release_media();
+
+        m_media = m.m_media;
+        m.m_media = nullptr;
+    }
 
     return *this;
 }
 
+void media::swap( media* m ) noexcept
+{
+    ::libvlc_media_t *const tmp = m->m_media;
+    m->m_media = m_media;
+    m_media = tmp;
+}
+
 std::string media::mrl() const
 {
     std::string ret;
-
-    if( !m_media )
-        return ret;
-
-    if( char* mrl = libvlc_media_get_mrl( m_media ) ) {
-        ret = mrl;
-        libvlc_free( mrl );
-    }
+    mrl( &ret );
 
     return ret;
 }
@@ -114,23 +134,71 @@ std::string media::mrl() const
 std::string media::meta( libvlc_meta_t meta_id ) const
 {
     std::string ret;
-
-    if( m_media ) {
-        if( char* meta = libvlc_media_get_meta( m_media, meta_id ) ) {
-            ret = meta;
-            libvlc_free( meta );
-        }
-    }
+    meta( meta_id, &ret );
 
     return ret;
 }
 
+bool media::mrl( std::string* out ) const
+{
+    out->clear();
+
+    if( !m_media )
+        return false;
+
+    char* mrl = libvlc_media_get_mrl( m_media );
+    if( !mrl )
+        return false;
+
+    out->assign( mrl );
+    libvlc_free( mrl );
+
+    return true;
+}
+
+bool media::meta( libvlc_meta_t meta_id, std::string* out ) const
+{
+    out->clear();
+
+    if( !m_media )
+        return false;
+
+    char* meta = libvlc_media_get_meta( m_media, meta_id );
+    if( !meta )
+        return false;
+
+    out->assign( meta );
+    libvlc_free( meta );
+
+    return true;
+}
+
 void media::set_meta( ::libvlc_meta_t meta_id, const std::string& meta )
 {
     if( m_media )
         libvlc_media_set_meta( m_media, meta_id, meta.c_str() );
 }
 
+void media::sub_items( std::vector<media>* out ) const
+{
+    if( !m_media )
+        return;
+
+    libvlc_media_list_t* list = libvlc_media_subitems( m_media );
+    if( !list )
+        return;
+
+    libvlc_media_list_lock( list );
+    const int count = libvlc_media_list_count( list );
+    for( int i = 0; i < count; ++i ) {
+        if( ::libvlc_media_t* item = libvlc_media_list_item_at_index( list, i ) )
+            out->push_back( media( item, false ) );
+    }
+    libvlc_media_list_unlock( list );
+
+    libvlc_media_list_release( list );
+}
+
 bool media::is_parsed() const
 {
     if( m_media )
@@ -27,6 +27,7 @@
 
 #include <vlc/vlc.h>
 #include <string>
+#include <vector>
 
 namespace vlc
 {
@@ -42,9 +43,13 @@ namespace vlc
         media();
         explicit media( ::libvlc_media_t*, bool needs_retain );
         media( const media& other );
+        media( media&& other ) noexcept;
         ~media();
 
         media& operator= ( const media& m );
+        media& operator= ( media&& m ) noexcept;
+
+        void swap( media* m ) noexcept;
 
         bool operator== ( const media& m ) const
             { return m_media == m.m_media; }
@@ -67,8 +72,15 @@ namespace vlc
 
         std::string mrl() const;
         std::string meta( ::libvlc_meta_t meta_id ) const;
+        //write to caller's string (reusing its buffer),
+        //return false (with out cleared) if there is no value
+        bool mrl( std::string* out ) const;
+        bool meta( ::libvlc_meta_t meta_id, std::string* out ) const;
         void set_meta( ::libvlc_meta_t meta_id, const std::string& meta );
 
+        //appends sub items media already has (f.e. items of parsed playlist)
+        void sub_items( std::vector<media>* out ) const;
+
     private:
         void release_media();
 
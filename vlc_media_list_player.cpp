@@ -25,6 +25,8 @@
 
 #include "vlc_media_list_player.h"
 
+#include "vlc_reaper.h"
+
 using namespace vlc;
 
 media_list_player::media_list_player()
@@ -103,6 +105,26 @@ void media_list_player::close()
     player_core::close();
 }
 
+void media_list_player::close_async()
+{
+    libvlc_media_list_player_t* mlp = _media_list_player;
+    libvlc_media_list_t* ml = _media_list;
+    _media_list_player = nullptr;
+    _media_list = nullptr;
+
+    //releasing media list player stops it
+    if( mlp || ml ) {
+        reaper::instance().post( [mlp, ml] () {
+            if( mlp )
+                libvlc_media_list_player_release( mlp );
+            if( ml )
+                libvlc_media_list_release( ml );
+        } );
+    }
+
+    player_core::close_async();
+}
+
 void media_list_player::play()
 {
     if( _media_list_player )
@@ -147,6 +169,10 @@ void media_list_player::set_playback_mode( playback_mode_e m )
         break;
     case mode_loop:
         libvlcMode = libvlc_playback_mode_loop;
+        break;
+    case mode_shuffle:
+        //not supported
+        return;
     }
 
     _mode = m;
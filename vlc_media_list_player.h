@@ -35,8 +35,10 @@ namespace vlc
         media_list_player();
         ~media_list_player();
 
+        using playlist_player_core::open;
         bool open( libvlc_instance_t* ) override;
         void close() override;
+        void close_async() override;
 
         void play() override;
         bool play( unsigned idx ) override;
@@ -55,6 +57,7 @@ namespace vlc
         void clear_items() override;
         unsigned item_count() override;
 
+        using playlist_player_core::get_media;
         vlc::media get_media( unsigned idx ) override;
         int find_media_index( const vlc::media& ) override;
 
@@ -0,0 +1,263 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "vlc_media_player_pool.h"
+
+#include <cassert>
+
+#include <mutex>
+#include <unordered_map>
+
+#include "vlc_reaper.h"
+
+using namespace vlc;
+
+typedef std::unordered_map<libvlc_instance_t*, media_player_pool*> pools_t;
+
+//pools registry, all pools data is guarded by registry lock
+static std::mutex& registry_guard()
+{
+    static std::mutex guard;
+    return guard;
+}
+
+static pools_t& registry()
+{
+    static pools_t pools;
+    return pools;
+}
+
+media_player_pool::media_player_pool( libvlc_instance_t* inst, unsigned warm_size )
+    : _libvlc_instance( inst ), _warm_size( warm_size ),
+      _hit_count( 0 ), _miss_count( 0 ), _recycled_count( 0 ), _discarded_count( 0 )
+{
+    assert( inst );
+
+    libvlc_retain( _libvlc_instance );
+
+    {
+        std::lock_guard<std::mutex> lock( registry_guard() );
+        const bool registered = registry().emplace( inst, this ).second;
+        assert( registered && "only one pool per instance is allowed" );
+        (void) registered;
+    }
+
+    warm_up();
+}
+
+media_player_pool::~media_player_pool()
+{
+    std::vector<libvlc_media_player_t*> idle;
+    {
+        std::lock_guard<std::mutex> lock( registry_guard() );
+
+        auto it = registry().find( _libvlc_instance );
+        if( it != registry().end() && it->second == this )
+            registry().erase( it );
+
+        idle.swap( _idle );
+    }
+
+    for( libvlc_media_player_t* mp: idle )
+        libvlc_media_player_release( mp );
+
+    libvlc_release( _libvlc_instance );
+}
+
+void media_player_pool::set_warm_size( unsigned warm_size )
+{
+    std::vector<libvlc_media_player_t*> excess;
+    {
+        std::lock_guard<std::mutex> lock( registry_guard() );
+
+        _warm_size = warm_size;
+        if( _idle.size() > warm_size ) {
+            excess.assign( _idle.begin() + warm_size, _idle.end() );
+            _idle.resize( warm_size );
+        }
+    }
+
+    for( libvlc_media_player_t* mp: excess )
+        libvlc_media_player_release( mp );
+}
+
+unsigned media_player_pool::warm_size() const
+{
+    std::lock_guard<std::mutex> lock( registry_guard() );
+    return _warm_size;
+}
+
+void media_player_pool::warm_up()
+{
+    for( ;; ) {
+        {
+            std::lock_guard<std::mutex> lock( registry_guard() );
+            if( _idle.size() >= _warm_size )
+                return;
+        }
+
+        //media player creation is slow, so it's done without lock
+        libvlc_media_player_t* mp = libvlc_media_player_new( _libvlc_instance );
+        if( !mp )
+            return;
+
+        std::lock_guard<std::mutex> lock( registry_guard() );
+        if( _idle.size() >= _warm_size ) {
+            //pool was filled by recycle meanwhile
+            libvlc_media_player_release( mp );
+            return;
+        }
+        _idle.push_back( mp );
+    }
+}
+
+unsigned media_player_pool::idle_count() const
+{
+    std::lock_guard<std::mutex> lock( registry_guard() );
+    return static_cast<unsigned>( _idle.size() );
+}
+
+uint64_t media_player_pool::hit_count() const
+{
+    std::lock_guard<std::mutex> lock( registry_guard() );
+    return _hit_count;
+}
+
+uint64_t media_player_pool::miss_count() const
+{
+    std::lock_guard<std::mutex> lock( registry_guard() );
+    return _miss_count;
+}
+
+uint64_t media_player_pool::recycled_count() const
+{
+    std::lock_guard<std::mutex> lock( registry_guard() );
+    return _recycled_count;
+}
+
+uint64_t media_player_pool::discarded_count() const
+{
+    std::lock_guard<std::mutex> lock( registry_guard() );
+    return _discarded_count;
+}
+
+libvlc_media_player_t* media_player_pool::acquire( libvlc_instance_t* inst )
+{
+    std::lock_guard<std::mutex> lock( registry_guard() );
+
+    auto it = registry().find( inst );
+    if( it == registry().end() )
+        return nullptr;
+
+    media_player_pool* pool = it->second;
+    if( pool->_idle.empty() ) {
+        ++pool->_miss_count;
+        return nullptr;
+    }
+
+    ++pool->_hit_count;
+    libvlc_media_player_t* mp = pool->_idle.back();
+    pool->_idle.pop_back();
+
+    return mp;
+}
+
+bool media_player_pool::recycle( libvlc_instance_t* inst, libvlc_media_player_t* mp )
+{
+    {
+        std::lock_guard<std::mutex> lock( registry_guard() );
+        if( registry().find( inst ) == registry().end() )
+            return false;
+    }
+
+    switch( libvlc_media_player_get_state( mp ) ) {
+    case libvlc_NothingSpecial:
+    case libvlc_Stopped:
+    case libvlc_Ended:
+    case libvlc_Error:
+        break;
+    default:
+        //stop could take a while, so let reaper do it and then try again
+        reaper::instance().post( [inst, mp] () {
+            libvlc_media_player_stop( mp );
+            if( !recycle( inst, mp ) )
+                libvlc_media_player_release( mp );
+        } );
+        return true;
+    }
+
+    reset( mp );
+
+    bool discard = false;
+    {
+        std::lock_guard<std::mutex> lock( registry_guard() );
+
+        auto it = registry().find( inst );
+        if( it == registry().end() )
+            return false;
+
+        media_player_pool* pool = it->second;
+        if( pool->_idle.size() < pool->_warm_size ) {
+            ++pool->_recycled_count;
+            pool->_idle.push_back( mp );
+        } else {
+            ++pool->_discarded_count;
+            discard = true;
+        }
+    }
+
+    if( discard )
+        libvlc_media_player_release( mp );
+
+    return true;
+}
+
+void media_player_pool::reset( libvlc_media_player_t* mp )
+{
+    libvlc_media_player_set_media( mp, nullptr );
+
+    libvlc_media_player_set_xwindow( mp, 0 );
+    libvlc_media_player_set_hwnd( mp, nullptr );
+    libvlc_media_player_set_nsobject( mp, nullptr );
+
+    libvlc_media_player_set_rate( mp, 1.f );
+
+    libvlc_audio_set_mute( mp, false );
+    libvlc_audio_set_volume( mp, 100 );
+    libvlc_audio_set_delay( mp, 0 );
+
+    libvlc_video_set_aspect_ratio( mp, nullptr );
+    libvlc_video_set_scale( mp, 0.f );
+    libvlc_video_set_crop_geometry( mp, nullptr );
+    libvlc_video_set_deinterlace( mp, nullptr );
+    libvlc_video_set_spu_delay( mp, 0 );
+
+    libvlc_video_set_adjust_int( mp, libvlc_adjust_Enable, 0 );
+    libvlc_video_set_marquee_int( mp, libvlc_marquee_Enable, 0 );
+    libvlc_video_set_logo_int( mp, libvlc_logo_enable, 0 );
+
+    libvlc_video_set_key_input( mp, true );
+    libvlc_video_set_mouse_input( mp, true );
+}
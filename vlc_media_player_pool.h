@@ -0,0 +1,91 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <vlc/vlc.h>
+
+namespace vlc
+{
+    //keeps created media players of one libvlc instance for reuse.
+    //While pool exists, every basic_player opened with the same instance
+    //takes media player from it, and returns it back on close
+    //(after it's stopped and reset to defaults: media, drawables, rate,
+    //audio and video settings, video filters).
+    //Media players with custom outputs (video/audio callbacks) are never
+    //returned to pool: basic_vmem_wrapper and audio::set_callbacks take care
+    //of it, and it should be done with basic_player::disable_pool_reuse
+    //if they are set directly through libvlc.
+    class media_player_pool
+    {
+    public:
+        media_player_pool( libvlc_instance_t* inst, unsigned warm_size = 4 );
+        ~media_player_pool();
+
+        media_player_pool( const media_player_pool& ) = delete;
+        media_player_pool& operator= ( const media_player_pool& ) = delete;
+
+        //max count of idle media players kept in pool
+        void set_warm_size( unsigned warm_size );
+        unsigned warm_size() const;
+        //creates idle media players up to warm size
+        void warm_up();
+
+        unsigned idle_count() const;
+
+        //acquire was served from pool
+        uint64_t hit_count() const;
+        //acquire had to create new media player
+        uint64_t miss_count() const;
+        //media player was returned to pool
+        uint64_t recycled_count() const;
+        //media player was released since pool was full
+        uint64_t discarded_count() const;
+
+        //returns media player from pool of inst, or 0 if there is
+        //no pool for inst or it's empty (caller should create new one then)
+        static libvlc_media_player_t* acquire( libvlc_instance_t* inst );
+        //takes over reference to media player,
+        //returns false if there is no pool for inst
+        static bool recycle( libvlc_instance_t* inst, libvlc_media_player_t* mp );
+
+    private:
+        static void reset( libvlc_media_player_t* mp );
+
+    private:
+        libvlc_instance_t* _libvlc_instance;
+        unsigned _warm_size;
+        std::vector<libvlc_media_player_t*> _idle;
+
+        uint64_t _hit_count;
+        uint64_t _miss_count;
+        uint64_t _recycled_count;
+        uint64_t _discarded_count;
+    };
+}
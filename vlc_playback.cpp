@@ -28,7 +28,7 @@
 using namespace vlc;
 
 playback::playback( vlc::basic_player& player )
-    : _player( player )
+    : _player( player ), _state_cache( nullptr )
 {
 }
 
@@ -45,11 +45,18 @@ void playback::set_rate( float rate )
     if( !_player.is_open() )
         return;
 
-    libvlc_media_player_set_rate( _player.get_mp(), rate );
+    if( libvlc_media_player_set_rate( _player.get_mp(), rate ) != 0 )
+        return;
+
+    if( player_state* state = _state_cache )
+        state->set_rate( rate );
 }
 
 float playback::get_position()
 {
+    if( player_state* state = _state_cache )
+        return state->position();
+
     if( !_player.is_open() )
         return 0.f;
 
@@ -64,10 +71,17 @@ void playback::set_position( float p )
         return;
 
     libvlc_media_player_set_position( _player.get_mp(), p );
+
+    player_state* state = _state_cache;
+    if( state && state->length() > 0 )
+        state->seek( static_cast<libvlc_time_t>( p * state->length() ) );
 }
 
 libvlc_time_t playback::get_time()
 {
+    if( player_state* state = _state_cache )
+        return state->time();
+
     if( !_player.is_open() )
         return 0;
 
@@ -82,10 +96,24 @@ void playback::set_time( libvlc_time_t t )
         return;
 
     libvlc_media_player_set_time( _player.get_mp(), t );
+
+    if( player_state* state = _state_cache )
+        state->seek( t );
+}
+
+libvlc_time_t playback::get_interpolated_time()
+{
+    if( player_state* state = _state_cache )
+        return state->interpolated_time();
+
+    return get_time();
 }
 
 libvlc_time_t playback::get_length()
 {
+    if( player_state* state = _state_cache )
+        return state->length();
+
     if( !_player.is_open() )
         return 0;
 
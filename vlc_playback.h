@@ -25,7 +25,10 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "vlc_basic_player.h"
+#include "vlc_player_state.h"
 
 namespace vlc
 {
@@ -43,11 +46,21 @@ namespace vlc
         libvlc_time_t get_time();
         void set_time( libvlc_time_t );
 
+        //smooth time extrapolated from last reported one,
+        //requires state cache (same as get_time otherwise)
+        libvlc_time_t get_interpolated_time();
+
         libvlc_time_t get_length();
 
         float get_fps();
 
+        //if set, get_position/get_time/get_length return cached values
+        //instead of asking libvlc. 0 - ask libvlc
+        void set_state_cache( player_state* state )
+            { _state_cache = state; }
+
     private:
         vlc::basic_player& _player;
+        std::atomic<player_state*> _state_cache;
     };
 }
@@ -29,13 +29,24 @@
 
 #include <limits>
 #include <algorithm>
+#include <chrono>
+
+#include "vlc_event_dispatcher.h"
+#include "vlc_event_trace.h"
+#include "vlc_instance_manager.h"
+#include "vlc_reaper.h"
 
 using namespace vlc;
 
-const unsigned vlc::PLAYLIST_MAX_SIZE = std::numeric_limits<short>::max();
+const unsigned vlc::PLAYLIST_MAX_SIZE = std::numeric_limits<int>::max();
 
 player_core::player_core()
-    : _libvlc_instance( nullptr ),
+    : _libvlc_instance( nullptr ), _instance_manager( nullptr ),
+      _events_enabled( false ), _attach_applying( false ),
+      _attach_requested( 0 ), _attach_applied( 0 ),
+      _attached_mp( nullptr ), _attached_events( 0 ), _event_dispatcher( nullptr ),
+      _event_recorder( nullptr ), _state_cache_enabled( false ),
+      _tracks_cache_enabled( false ),
       _playback( _player ), _video( _player ),
       _audio( _player ), _subtitles( _player )
 {
@@ -48,11 +59,21 @@ player_core::~player_core()
 
 bool player_core::open( libvlc_instance_t* inst )
 {
+    //reopened with other instance, media player (if any)
+    //keeps own reference to managed one
+    if( instance_manager* manager = _instance_manager ) {
+        _instance_manager = nullptr;
+        manager->release( _libvlc_instance );
+    }
+
+    //old media player (if any) will be closed by _player
+    if( is_open() )
+        detach_events();
+
     _libvlc_instance = inst;
 
     if( _player.open( inst ) ) {
-        if( has_callbacks() )
-            events_attach( true );
+        attach_events();
 
         return true;
     }
@@ -60,16 +81,142 @@ bool player_core::open( libvlc_instance_t* inst )
     return false;
 }
 
+bool player_core::open( instance_manager* manager )
+{
+    if( is_open() )
+        close();
+
+    libvlc_instance_t* inst = manager->acquire();
+    if( !inst )
+        return false;
+
+    if( !open( inst ) ) {
+        _libvlc_instance = nullptr;
+        manager->release( inst );
+        return false;
+    }
+
+    _instance_manager = manager;
+
+    return true;
+}
+
 void player_core::close()
 {
-    if( has_callbacks() )
-        events_attach( false );
+    internal_close( false );
+}
+
+void player_core::close_async()
+{
+    internal_close( true );
+}
+
+void player_core::internal_close( bool async )
+{
+    detach_events();
+
+    if( event_dispatcher* dispatcher = _event_dispatcher )
+        dispatcher->cancel( this );
 
     assert( !has_callbacks() );
     clear_callbacks();
 
-    _player.close();
+    if( async )
+        _player.close_async();
+    else
+        _player.close();
+
+    if( instance_manager* manager = _instance_manager ) {
+        _instance_manager = nullptr;
+        manager->release( _libvlc_instance );
+    }
     _libvlc_instance = 0;
+
+    _cached_state.reset( nullptr );
+    invalidate_tracks();
+}
+
+libvlc_state_t player_core::get_state()
+{
+    if( _state_cache_enabled )
+        return _cached_state.state();
+
+    return _player.get_state();
+}
+
+void player_core::snapshot( player_snapshot* s )
+{
+    *s = player_snapshot();
+
+    libvlc_media_player_t* mp = get_mp();
+    if( !mp )
+        return;
+
+    if( _state_cache_enabled ) {
+        s->state = _cached_state.state();
+        s->time = _cached_state.time();
+        s->interpolated_time = _cached_state.interpolated_time();
+        s->position = _cached_state.position();
+        s->length = _cached_state.length();
+        s->rate = _cached_state.rate();
+    } else {
+        s->state = libvlc_media_player_get_state( mp );
+
+        const libvlc_time_t t = libvlc_media_player_get_time( mp );
+        s->time = t < 0 ? 0 : t;
+        s->interpolated_time = s->time;
+
+        const float p = libvlc_media_player_get_position( mp );
+        s->position = p < 0 ? 0.f : p;
+
+        const libvlc_time_t l = libvlc_media_player_get_length( mp );
+        s->length = l < 0 ? 0 : l;
+
+        s->rate = libvlc_media_player_get_rate( mp );
+    }
+
+    s->fps = libvlc_media_player_get_fps( mp );
+
+    const int v = libvlc_audio_get_volume( mp );
+    s->volume = v < 0 ? 0 : v;
+    s->muted = libvlc_audio_get_mute( mp ) != 0;
+
+    s->audio_track = _audio.get_track();
+    s->video_track = _video.get_track();
+    s->subtitles_track = _subtitles.get_track();
+}
+
+void player_core::set_state_cache( bool enable )
+{
+    if( enable == _state_cache_enabled )
+        return;
+
+    _state_cache_enabled = enable;
+
+    sync_events_attach( true );
+
+    //state is read from libvlc after events are attached,
+    //so nothing will be missed
+    if( enable )
+        _cached_state.reset( get_mp() );
+
+    _playback.set_state_cache( enable ? &_cached_state : nullptr );
+}
+
+void player_core::set_tracks_cache( bool enable )
+{
+    if( enable == _tracks_cache_enabled )
+        return;
+
+    _tracks_cache_enabled = enable;
+
+    sync_events_attach( true );
+
+    //tables are invalidated after events are attached,
+    //so no tracks change will be missed
+    _audio.set_tracks_cache( enable );
+    _video.set_tracks_cache( enable );
+    _subtitles.set_tracks_cache( enable );
 }
 
 void player_core::pause()
@@ -87,35 +234,196 @@ void player_core::stop()
     _player.stop();
 }
 
+void player_core::stop_async()
+{
+    _player.stop_async();
+}
+
+//libvlc doesn't report elementary streams changes,
+//so tracks tables are refreshed after events which usually accompany them
+static media_player_events_mask_t tracks_events_mask()
+{
+    return media_player_event_mask( libvlc_MediaPlayerMediaChanged ) |
+           media_player_event_mask( libvlc_MediaPlayerOpening ) |
+           media_player_event_mask( libvlc_MediaPlayerBuffering ) |
+           media_player_event_mask( libvlc_MediaPlayerPlaying ) |
+           media_player_event_mask( libvlc_MediaPlayerStopped ) |
+           media_player_event_mask( libvlc_MediaPlayerEndReached ) |
+           media_player_event_mask( libvlc_MediaPlayerEncounteredError ) |
+           media_player_event_mask( libvlc_MediaPlayerSeekableChanged ) |
+           media_player_event_mask( libvlc_MediaPlayerPausableChanged ) |
+           media_player_event_mask( libvlc_MediaPlayerLengthChanged );
+}
+
 void player_core::event_proxy( const libvlc_event_t* e, void* param )
 {
     if( !param )
         return;
 
-    static_cast<player_core*>( param )->event( e );
+    player_core* core = static_cast<player_core*>( param );
+
+    if( core->_state_cache_enabled )
+        core->_cached_state.update( e );
+
+    if( core->_tracks_cache_enabled &&
+        ( media_player_event_mask( e->type ) & tracks_events_mask() ) )
+    {
+        core->invalidate_tracks();
+    }
+
+    if( event_trace_recorder* recorder = core->_event_recorder )
+        recorder->record( e );
+
+    event_dispatcher* dispatcher = core->_event_dispatcher;
+    if( dispatcher && dispatcher->post( core, e ) )
+        return;
+
+    core->event( e );
 }
 
 void player_core::event( const libvlc_event_t* e )
 {
-    for_each_callback(
-        [e] ( media_player_events_callback *const & callback )
+    for_each_callback( media_player_event_mask( e->type ),
+        [e] ( media_player_events_callback* callback )
         {
             callback->media_player_event( e );
         }
     );
 }
 
-void player_core::events_attach( bool attach )
+void player_core::events_attach( bool /*attach*/ )
 {
-    if( !is_open() )
+    //media player events always follow registered callbacks
+    //(internal events stay attached while media player is open),
+    //detach_events() detaches everything explicitly
+    sync_events_attach( false );
+}
+
+void player_core::invalidate_tracks()
+{
+    _audio.invalidate_tracks();
+    _video.invalidate_tracks();
+    _subtitles.invalidate_tracks();
+}
+
+media_player_events_mask_t player_core::internal_events_mask() const
+{
+    media_player_events_mask_t mask = 0;
+
+    if( _tracks_cache_enabled )
+        mask |= tracks_events_mask();
+
+    if( !_state_cache_enabled )
+        return mask;
+
+    return mask |
+           media_player_event_mask( libvlc_MediaPlayerMediaChanged ) |
+           media_player_event_mask( libvlc_MediaPlayerNothingSpecial ) |
+           media_player_event_mask( libvlc_MediaPlayerOpening ) |
+           media_player_event_mask( libvlc_MediaPlayerPlaying ) |
+           media_player_event_mask( libvlc_MediaPlayerPaused ) |
+           media_player_event_mask( libvlc_MediaPlayerStopped ) |
+           media_player_event_mask( libvlc_MediaPlayerEndReached ) |
+           media_player_event_mask( libvlc_MediaPlayerEncounteredError ) |
+           media_player_event_mask( libvlc_MediaPlayerTimeChanged ) |
+           media_player_event_mask( libvlc_MediaPlayerPositionChanged ) |
+           media_player_event_mask( libvlc_MediaPlayerLengthChanged );
+}
+
+void player_core::attach_events()
+{
+    {
+        std::lock_guard<std::mutex> lock( _attach_guard );
+        _events_enabled = true;
+    }
+
+    if( has_callbacks() )
+        events_attach( true );
+
+    sync_events_attach( true );
+
+    invalidate_tracks();
+
+    if( _state_cache_enabled )
+        _cached_state.reset( get_mp() );
+}
+
+void player_core::detach_events()
+{
+    if( has_callbacks() )
+        events_attach( false );
+
+    {
+        std::lock_guard<std::mutex> lock( _attach_guard );
+        _events_enabled = false;
+    }
+
+    sync_events_attach( true );
+}
+
+void player_core::sync_events_attach( bool wait )
+{
+    std::unique_lock<std::mutex> lock( _attach_guard );
+
+    const uint64_t request = ++_attach_requested;
+
+    if( _attach_applying ) {
+        //applying thread will apply this request too
+        if( wait ) {
+            _attach_applied_cond.wait( lock,
+                [this, request] () { return _attach_applied >= request; } );
+        }
         return;
+    }
 
-   libvlc_event_manager_t* em =
-        libvlc_media_player_event_manager( get_mp() );
+    _attach_applying = true;
+
+    while( _attach_applied != _attach_requested ) {
+        const uint64_t applying = _attach_requested;
+        const media_player_events_mask_t events_mask =
+            _events_enabled ? internal_events_mask() | callbacks_events_mask() : 0;
+
+        lock.unlock();
+        apply_events_mask( events_mask );
+        lock.lock();
+
+        _attach_applied = applying;
+        _attach_applied_cond.notify_all();
+    }
+
+    _attach_applying = false;
+}
+
+void player_core::apply_events_mask( media_player_events_mask_t events_mask )
+{
+    //media player is not touched while events are disabled,
+    //since it could be changed by owner thread meanwhile
+    libvlc_media_player_t* mp = events_mask ? get_mp() : nullptr;
+
+    //events still attached to old media player should go away
+    if( _attached_mp && _attached_mp != mp )
+        apply_events_mask( _attached_mp, 0 );
+
+    if( mp )
+        apply_events_mask( mp, events_mask );
+}
+
+void player_core::apply_events_mask( libvlc_media_player_t* mp,
+                                     media_player_events_mask_t events_mask )
+{
+    libvlc_event_manager_t* em = libvlc_media_player_event_manager( mp );
     if( !em )
         return;
 
+    if( mp != _attached_mp )
+        _attached_events = 0;
+
+    media_player_events_mask_t attached_events = 0;
     for( int e = libvlc_MediaPlayerMediaChanged; e <= libvlc_MediaPlayerVout; ++e ) {
+        const media_player_events_mask_t e_mask = media_player_event_mask( e );
+        const bool attach = ( events_mask & e_mask ) != 0;
+        const bool attached = ( _attached_events & e_mask ) != 0;
+
         switch( e ){
         case libvlc_MediaPlayerMediaChanged:
         case libvlc_MediaPlayerNothingSpecial:
@@ -136,29 +444,62 @@ void player_core::events_attach( bool attach )
         //case libvlc_MediaPlayerSnapshotTaken:
         case libvlc_MediaPlayerLengthChanged:
         //case libvlc_MediaPlayerVout:
-            if( attach )
+            if( attach && !attached )
                 libvlc_event_attach( em, e, event_proxy, this );
-            else
+            else if( !attach && attached )
                 libvlc_event_detach( em, e, event_proxy, this );
+
+            if( attach )
+                attached_events |= e_mask;
             break;
         }
     }
+
+    _attached_events = attached_events;
+    _attached_mp = attached_events ? mp : nullptr;
 }
 
-void player_core::register_callback( media_player_events_callback* callback )
+player_core::callback_handle
+player_core::register_callback( media_player_events_callback* callback,
+                                media_player_events_mask_t events_mask )
 {
-    if( !has_callbacks() )
+    const bool had_callbacks = has_callbacks();
+
+    callback_handle handle =
+        callbacks_holder::register_callback( callback, events_mask );
+
+    if( !had_callbacks )
         events_attach( true );
+    else
+        sync_events_attach( false );
 
-    callbacks_holder::register_callback( callback );
+    return handle;
 }
 
-void player_core::unregister_callback( media_player_events_callback* callback )
+void player_core::unregister_callback( const callback_handle& handle )
 {
-    callbacks_holder::unregister_callback( callback );
+    callbacks_holder::unregister_callback( handle );
 
     if( !has_callbacks() )
         events_attach( false );
+    else
+        sync_events_attach( false );
+}
+
+void player_core::swap_player( vlc::basic_player* p )
+{
+    detach_events();
+
+    _player.swap( p );
+
+    attach_events();
+}
+
+void player_core::set_event_dispatcher( event_dispatcher* dispatcher )
+{
+    event_dispatcher* old_dispatcher = _event_dispatcher.exchange( dispatcher );
+    if( old_dispatcher && old_dispatcher != dispatcher )
+        old_dispatcher->cancel( this );
 }
 
 void player_core::swap( player_core* p )
@@ -170,19 +511,17 @@ void player_core::swap( player_core* p )
     p->_libvlc_instance = _libvlc_instance;
     _libvlc_instance = tmp_libvlc;
 
-    if( p->has_callbacks() )
-        p->events_attach( false );
+    instance_manager *const tmp_manager = p->_instance_manager;
+    p->_instance_manager = _instance_manager;
+    _instance_manager = tmp_manager;
 
-    if( has_callbacks() )
-        events_attach( false );
+    p->detach_events();
+    detach_events();
 
     _player.swap( &( p->_player ) );
 
-    if( p->has_callbacks() )
-        p->events_attach( true );
-
-    if( has_callbacks() )
-        events_attach( true );
+    p->attach_events();
+    attach_events();
 }
 
 
@@ -200,37 +539,303 @@ int playlist_player_core::add_media( const char* mrl_or_path,
                              trusted_optc, trusted_optv, is_path ) );
 }
 
-
 player::player()
-    : _mode( mode_single ), _current_idx( -1 )
+    : _mode( mode_single ), _current_idx( -1 ),
+      _gapless( false ), _preload_time( 5000 ), _preload_watcher( this ),
+      _preload_id( invalid_item_id ), _standby_id( invalid_item_id ),
+      _preload_token( std::make_shared<preload_token>() ),
+      _switched_id( invalid_item_id ),
+      _shuffle_valid( false ), _shuffle_available( 0 ), _shuffle_enabled( 0 ),
+      _shuffle_round( 0 ), _shuffle_last_id( invalid_item_id ), _shuffle_pos( -1 ),
+      _shuffle_rng( static_cast<std::minstd_rand::result_type>(
+          std::chrono::steady_clock::now().time_since_epoch().count() ) )
+{
+}
+
+player::~player()
+{
+    //preload watcher, standby player and sub items watch
+    //should go away before player_core will be destroyed
+    close();
+}
+
+bool player::open( libvlc_instance_t* inst )
 {
+    if( !player_core::open( inst ) )
+        return false;
+
+    if( _gapless && !_preload_watcher_handle ) {
+        _preload_watcher_handle =
+            register_callback( &_preload_watcher,
+                               media_player_event_mask( libvlc_MediaPlayerTimeChanged ) );
+    }
+
+    return true;
 }
 
 void player::close()
 {
+    close_preload( false );
+
     player_core::close();
 
     clear_items();
 }
 
+void player::close_async()
+{
+    close_preload( true );
+
+    player_core::close_async();
+
+    clear_items();
+}
+
+void player::close_preload( bool async )
+{
+    if( _preload_watcher_handle ) {
+        unregister_callback( _preload_watcher_handle );
+        _preload_watcher_handle = callback_handle();
+    }
+
+    reset_preload();
+    if( async )
+        _standby.close_async();
+    else
+        _standby.close();
+
+    watch_sub_items( vlc::media() );
+}
+
+int player::add_media( const char* mrl_or_path,
+                       unsigned optc, const char** optv,
+                       unsigned trusted_optc, const char** trusted_optv,
+                       bool is_path /*= false*/ )
+{
+    if( !is_open() || _playlist.size() >= PLAYLIST_MAX_SIZE ||
+        !mrl_or_path || !*mrl_or_path )
+    {
+        return -1;
+    }
+
+    _playlist.insert_lazy( _playlist.size(), &mrl_or_path, 1,
+                           optc, optv, trusted_optc, trusted_optv, is_path );
+
+    return static_cast<int>( _playlist.size() - 1 );
+}
+
 int player::add_media( const vlc::media& media )
 {
     if( !is_open() || _playlist.size() >= PLAYLIST_MAX_SIZE || !media )
         return -1;
 
-    playlist_item item = { media, false, std::string() };
-    playlist_it it = _playlist.insert( _playlist.end(), item );
+    _playlist.push_back( media );
+
+    return static_cast<int>( _playlist.size() - 1 );
+}
+
+playlist_item_id_t player::add_media_item( const vlc::media& media )
+{
+    const int idx = add_media( media );
+
+    return idx < 0 ? invalid_item_id : _playlist.id( idx );
+}
+
+playlist_item_id_t player::item_id( unsigned idx )
+{
+    if( idx >= _playlist.size() )
+        return invalid_item_id;
+
+    return _playlist.id( idx );
+}
 
-    return static_cast<int>( it - _playlist.begin() );
+int player::item_index( playlist_item_id_t id )
+{
+    return _playlist.find_id( id );
+}
+
+playlist_item_id_t player::current_item_id()
+{
+    if( _current_idx < 0 )
+        return invalid_item_id;
+
+    return item_id( _current_idx );
+}
+
+bool player::play_by_id( playlist_item_id_t id )
+{
+    const int idx = _playlist.find_id( id );
+
+    return idx >= 0 && play( idx );
+}
+
+bool player::delete_item_by_id( playlist_item_id_t id )
+{
+    const int idx = _playlist.find_id( id );
+
+    return idx >= 0 && delete_item( idx );
+}
+
+void player::disable_item_by_id( playlist_item_id_t id, bool disable )
+{
+    const int idx = _playlist.find_id( id );
+    if( idx >= 0 )
+        disable_item( idx, disable );
+}
+
+void player::set_item_data_by_id( playlist_item_id_t id, const std::string& data )
+{
+    const int idx = _playlist.find_id( id );
+    if( idx >= 0 )
+        set_item_data( idx, data );
+}
+
+int player::add_media_items( const char* const* mrls_or_paths, unsigned count,
+                             unsigned optc, const char** optv,
+                             bool is_path /*= false*/ )
+{
+    if( !is_open() )
+        return -1;
+
+    const unsigned first_idx = _playlist.size();
+    if( count > PLAYLIST_MAX_SIZE - first_idx )
+        count = PLAYLIST_MAX_SIZE - first_idx;
+
+    if( count >= first_idx )
+        _playlist.reserve( first_idx + count );
+
+    //insert runs of valid mrls at once
+    unsigned run_begin = 0;
+    for( unsigned i = 0; i <= count; ++i ) {
+        if( i < count && mrls_or_paths[i] && *mrls_or_paths[i] )
+            continue;
+
+        if( i > run_begin ) {
+            _playlist.insert_lazy( _playlist.size(),
+                                   mrls_or_paths + run_begin, i - run_begin,
+                                   optc, optv, 0, 0, is_path );
+        }
+        run_begin = i + 1;
+    }
+
+    return _playlist.size() > first_idx ? static_cast<int>( first_idx ) : -1;
+}
+
+int player::add_media_items( const vlc::media* media, unsigned count )
+{
+    if( !is_open() )
+        return -1;
+
+    const unsigned first_idx = _playlist.size();
+    if( count > PLAYLIST_MAX_SIZE - first_idx )
+        count = PLAYLIST_MAX_SIZE - first_idx;
+
+    //reserve only if storage at least doubles,
+    //otherwise it's cheaper to let containers grow geometrically
+    if( count >= first_idx )
+        _playlist.reserve( first_idx + count );
+
+    //insert runs of valid media at once
+    unsigned run_begin = 0;
+    for( unsigned i = 0; i <= count; ++i ) {
+        if( i < count && media[i] )
+            continue;
+
+        if( i > run_begin ) {
+            _playlist.insert( _playlist.size(),
+                              media + run_begin, i - run_begin,
+                              std::string() );
+        }
+        run_begin = i + 1;
+    }
+
+    return _playlist.size() > first_idx ? static_cast<int>( first_idx ) : -1;
+}
+
+bool player::delete_items( unsigned idx, unsigned count )
+{
+    const unsigned sz = _playlist.size();
+    if( !count || idx >= sz || count > sz - idx )
+        return false;
+
+    const bool current_deleted =
+        _current_idx >= 0 &&
+        unsigned( _current_idx ) >= idx && unsigned( _current_idx ) < idx + count;
+    const bool play_next = current_deleted && _player.is_playing();
+
+    //see delete_item
+    playlist_item_id_t deleted_id = invalid_item_id;
+    if( play_next && mode_shuffle == _mode ) {
+        shuffle_sync_current();
+        deleted_id = current_item_id();
+    }
+
+    shuffle_pool_erase( idx, count );
+    _playlist.erase( idx, count );
+
+    if( current_deleted ) {
+        //item after deleted range becomes current, or last item if there is no such
+        _current_idx = std::min<int>( idx, int( _playlist.size() ) - 1 );
+    } else if( _current_idx >= 0 && unsigned( _current_idx ) >= idx + count ) {
+        _current_idx -= count;
+    }
+
+    //if deleting item which is playing now - have to play next item
+    if( play_next ) {
+        internal_play( mode_shuffle == _mode ?
+                           shuffle_forward( deleted_id, true ) :
+                           find_valid_item( idx, true ) );
+    }
+
+    return true;
+}
+
+bool player::reorder_items( const unsigned* order, unsigned count )
+{
+    const unsigned sz = _playlist.size();
+    if( count != sz )
+        return false;
+
+    //check order is permutation
+    std::vector<bool> seen( sz, false );
+    for( unsigned i = 0; i < sz; ++i ) {
+        if( order[i] >= sz || seen[order[i]] )
+            return false;
+        seen[order[i]] = true;
+    }
+
+    _playlist.permute( order );
+
+    if( _current_idx >= 0 && unsigned( _current_idx ) < sz ) {
+        const unsigned old_current = _current_idx;
+        for( unsigned i = 0; i < sz; ++i ) {
+            if( order[i] == old_current ) {
+                _current_idx = i;
+                break;
+            }
+        }
+    }
+
+    return true;
 }
 
 bool player::delete_item( unsigned idx )
 {
-    unsigned sz = static_cast<unsigned>( _playlist.size() );
+    unsigned sz = _playlist.size();
     assert( _current_idx >= 0 && unsigned( _current_idx ) < sz );
 
     if( sz && idx < sz ) {
         const int save_current = _current_idx;
+        const bool play_next =
+            save_current >= 0 && unsigned( save_current ) == idx && _player.is_playing();
+
+        //in shuffle mode next item is drawn from pool (as next() does),
+        //deleted current item should stay in history for that
+        playlist_item_id_t deleted_id = invalid_item_id;
+        if( play_next && mode_shuffle == _mode ) {
+            shuffle_sync_current();
+            deleted_id = current_item_id();
+        }
 
         if( _current_idx >= 0 &&
             ( unsigned( _current_idx ) > idx ||
@@ -241,14 +846,16 @@ bool player::delete_item( unsigned idx )
             --_current_idx;
         }
 
-        playlist_it it = ( _playlist.begin() + idx );
-
-        _playlist.erase( it );
+        shuffle_pool_erase( idx, 1 );
+        _playlist.erase( idx );
         assert( _current_idx < 0 || unsigned( _current_idx ) < _playlist.size() );
 
         //if deleting item which is playing now - have to play next item
-        if( save_current >= 0 && unsigned( save_current ) == idx && is_playing() )
-            internal_play( find_valid_item( save_current, true ) );
+        if( play_next ) {
+            internal_play( mode_shuffle == _mode ?
+                               shuffle_forward( deleted_id, true ) :
+                               find_valid_item( save_current, true ) );
+        }
 
         return true;
     }
@@ -259,6 +866,8 @@ bool player::delete_item( unsigned idx )
 void player::clear_items()
 {
     _playlist.clear();
+    _materialized.clear();
+    shuffle_reset();
 
     _current_idx = -1;
 
@@ -269,7 +878,7 @@ void player::clear_items()
 
 unsigned player::item_count()
 {
-    return static_cast<unsigned>( _playlist.size() );
+    return _playlist.size();
 }
 
 void player::disable_item( unsigned idx, bool disable )
@@ -277,7 +886,12 @@ void player::disable_item( unsigned idx, bool disable )
     if( idx >= _playlist.size() )
         return;
 
-    _playlist[idx].disabled = disable;
+    _playlist.set_disabled( idx, disable );
+
+    if( _shuffle_valid ) {
+        shuffle_sync_pool();
+        shuffle_pool_set_disabled( _playlist.id( idx ), disable );
+    }
 }
 
 bool player::is_item_disabled( unsigned idx )
@@ -285,7 +899,7 @@ bool player::is_item_disabled( unsigned idx )
     if( idx >= _playlist.size() )
         return false;
 
-    return _playlist[idx].disabled;
+    return _playlist.is_disabled( idx );
 }
 
 void player::set_item_data( unsigned idx, const std::string& data )
@@ -293,7 +907,7 @@ void player::set_item_data( unsigned idx, const std::string& data )
     if( idx >= _playlist.size() )
         return;
 
-    _playlist[idx].data = data;
+    _playlist.set_data( idx, data );
 }
 
 const std::string& player::get_item_data( unsigned idx )
@@ -303,7 +917,7 @@ const std::string& player::get_item_data( unsigned idx )
     if( idx >= _playlist.size() )
         return empty;
 
-    return _playlist[idx].data;
+    return _playlist.data( idx );
 }
 
 void player::advance_item( unsigned idx, int count )
@@ -316,9 +930,7 @@ void player::advance_item( unsigned idx, int count )
         return;
     }
 
-    playlist_item save_item = _playlist[idx];
-    _playlist.erase( _playlist.begin() + idx );
-    _playlist.insert( _playlist.begin() + idx + count, save_item );
+    _playlist.move( idx, idx + count );
 
     if( _current_idx < 0 )
         return;
@@ -336,19 +948,63 @@ vlc::media player::get_media( unsigned idx )
     if( idx >= _playlist.size() )
         return vlc::media();
 
-    return _playlist[idx].media;
+    vlc::media media = item_media( idx );
+
+    //don't let get_media calls accumulate created media
+    enum { MAX_MATERIALIZED_ITEMS = 16 };
+    if( _materialized.size() > MAX_MATERIALIZED_ITEMS )
+        update_materialized();
+
+    return media;
+}
+
+vlc::media player::item_media( unsigned idx )
+{
+    if( _playlist.is_lazy( idx ) && !_playlist.libvlc_media( idx ) ) {
+        if( !_playlist.materialize( idx, _libvlc_instance ) )
+            return vlc::media();
+
+        _materialized.push_back( _playlist.id( idx ) );
+    }
+
+    return _playlist.media( idx );
+}
+
+void player::update_materialized()
+{
+    const playlist_item_id_t current_id = current_item_id();
+    const int next_idx =
+        _current_idx < 0 ? -1 : next_item_idx( false );
+    const playlist_item_id_t next_id =
+        next_idx < 0 ? invalid_item_id : _playlist.id( next_idx );
+
+    auto end =
+        std::remove_if( _materialized.begin(), _materialized.end(),
+            [&] ( playlist_item_id_t id ) {
+                if( id == current_id || id == next_id )
+                    return false;
+
+                const int idx = _playlist.find_id( id );
+                if( idx >= 0 )
+                    _playlist.dematerialize( idx );
+
+                return true;
+            } );
+    _materialized.erase( end, _materialized.end() );
+
+    if( next_idx >= 0 )
+        item_media( next_idx );
 }
 
 int player::find_media_index( const vlc::media& media )
 {
-    playlist_cit it =
-        std::find_if( _playlist.begin(), _playlist.end(),
-            [&media] ( const playlist_item& item ) -> bool {
-                return media == item.media;
-            }
-        );
+    if( media && media == _switched_media ) {
+        const int idx = _playlist.find_id( _switched_id );
+        if( idx >= 0 )
+            return idx;
+    }
 
-    return ( _playlist.end() == it ) ? -1 : static_cast<unsigned>( it - _playlist.begin() );
+    return _playlist.find( media.libvlc_media_t() );
 }
 
 int player::current_item()
@@ -360,7 +1016,13 @@ void player::set_current( unsigned idx )
 {
     if( idx < _playlist.size() ) {
         _current_idx = idx;
-        _player.set_media( _playlist[_current_idx].media );
+        vlc::media media = item_media( _current_idx );
+        _player.set_media( media );
+        watch_sub_items( std::move( media ) );
+        _switched_id = invalid_item_id;
+        _switched_media = vlc::media();
+        update_materialized();
+        prepare_preload();
     }
 }
 
@@ -370,13 +1032,252 @@ void player::internal_play( int idx )
         return;
     }
 
-    if( _player.current_media() != _playlist[idx].media ||
-        libvlc_Ended == get_state() )
-    {
+    if( switch_to_preloaded( idx ) )
+        return;
+
+    if( !is_loaded( idx ) || libvlc_Ended == _player.get_state() )
         set_current( idx );
+
+    _player.play();
+}
+
+bool player::is_loaded( unsigned idx )
+{
+    //media of lazy item could be not created yet,
+    //so empty media player doesn't match it
+    const vlc::media current_media = _player.current_media();
+    if( !current_media )
+        return false;
+
+    if( current_media == _playlist.libvlc_media( idx ) )
+        return true;
+
+    return _switched_id == _playlist.id( idx ) &&
+           current_media == _switched_media;
+}
+
+void player::set_gapless( bool gapless )
+{
+    if( gapless == _gapless )
+        return;
+
+    _gapless = gapless;
+
+    if( gapless ) {
+        _preload_watcher_handle =
+            register_callback( &_preload_watcher,
+                               media_player_event_mask( libvlc_MediaPlayerTimeChanged ) );
+        prepare_preload();
+    } else {
+        if( _preload_watcher_handle ) {
+            unregister_callback( _preload_watcher_handle );
+            _preload_watcher_handle = callback_handle();
+        }
+        reset_preload();
+    }
+}
+
+void player::prepare_preload()
+{
+    if( !_gapless )
+        return;
+
+    const int next_idx =
+        _current_idx < 0 ? -1 : next_item_idx( false );
+
+    playlist_item_id_t next_id = invalid_item_id;
+    vlc::media next_media;
+    if( next_idx >= 0 && next_idx != _current_idx ) {
+        next_id = _playlist.id( next_idx );
+        next_media = item_media( next_idx );
+    }
+
+    std::lock_guard<std::mutex> lock( _standby_guard );
+
+    if( _standby_id != next_id ) {
+        stop_standby();
+        _standby_id = invalid_item_id;
+        _standby_media = vlc::media();
+    }
+
+    _preload_id = next_media ? next_id : invalid_item_id;
+    _preload_media = std::move( next_media );
+}
+
+void player::stop_standby()
+{
+    if( _standby.stop_pending() )
+        return;
+
+    switch( _standby.get_state() ) {
+    case libvlc_NothingSpecial:
+    case libvlc_Stopped:
+        return;
+    default:
+        //media is left as is, since set_media would wait for stop
+        _standby.stop_async();
+    }
+}
+
+void player::reset_preload()
+{
+    std::weak_ptr<preload_token> token;
+    std::shared_future<void> job;
+    {
+        std::lock_guard<std::mutex> lock( _standby_guard );
+
+        token = _preload_token;
+        _preload_token = std::make_shared<preload_token>();
+        job = _preload_job;
+        _preload_job = std::shared_future<void>();
     }
 
+    //job keeps token alive only while it's preloading,
+    //and it never waits for _standby_guard
+    if( !token.expired() && job.valid() )
+        job.wait();
+
+    std::lock_guard<std::mutex> lock( _standby_guard );
+
+    stop_standby();
+    _standby_id = invalid_item_id;
+    _standby_media = vlc::media();
+
+    _preload_id = invalid_item_id;
+    _preload_media = vlc::media();
+}
+
+void player::preload_event( const libvlc_event_t* e )
+{
+    if( libvlc_MediaPlayerTimeChanged != e->type || !_gapless )
+        return;
+
+    //never wait here: _standby_guard owner could wait for this thread
+    //(f.e. while detaching events)
+    std::unique_lock<std::mutex> lock( _standby_guard, std::try_to_lock );
+    if( !lock.owns_lock() )
+        return;
+
+    if( invalid_item_id == _preload_id || _standby_id == _preload_id )
+        return;
+
+    //previous job is not done yet
+    if( _preload_job.valid() &&
+        _preload_job.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready )
+    {
+        return;
+    }
+
+    libvlc_media_player_t* mp = _player.get_mp();
+    const libvlc_time_t length = mp ? libvlc_media_player_get_length( mp ) : 0;
+    if( length <= 0 ||
+        length - e->u.media_player_time_changed.new_time > _preload_time )
+    {
+        return;
+    }
+
+    //opening media player and media could take a while,
+    //so it's not done on libvlc thread
+    const std::weak_ptr<preload_token> token = _preload_token;
+    _preload_job = reaper::instance().post( [this, token] () {
+        if( const std::shared_ptr<preload_token> locked = token.lock() )
+            preload();
+    } );
+}
+
+void player::preload()
+{
+    //_standby_guard owner could wait for reaper,
+    //there will be next TimeChanged anyway
+    std::unique_lock<std::mutex> lock( _standby_guard, std::try_to_lock );
+    if( !lock.owns_lock() )
+        return;
+
+    if( invalid_item_id == _preload_id || _standby_id == _preload_id )
+        return;
+
+    libvlc_media_player_t* mp = _player.get_mp();
+    if( !mp )
+        return;
+
+    if( !_standby.is_open() && !_standby.open( _libvlc_instance ) )
+        return;
+
+    //stop job posted after this one would never be done while waiting for it
+    if( _standby.stop_pending() )
+        return;
+
+    libvlc_media_player_t* standby_mp = _standby.get_mp();
+    if( const uint32_t xwindow = libvlc_media_player_get_xwindow( mp ) )
+        libvlc_media_player_set_xwindow( standby_mp, xwindow );
+    if( void* hwnd = libvlc_media_player_get_hwnd( mp ) )
+        libvlc_media_player_set_hwnd( standby_mp, hwnd );
+    if( void* nsobject = libvlc_media_player_get_nsobject( mp ) )
+        libvlc_media_player_set_nsobject( standby_mp, nsobject );
+
+    //playlist media is left untouched, since start-paused option
+    //would affect all next plays of it
+    ::libvlc_media_t* duplicate =
+        libvlc_media_duplicate( _preload_media.libvlc_media_t() );
+    if( !duplicate )
+        return;
+
+    libvlc_media_add_option( duplicate, ":start-paused" );
+
+    _standby_media = vlc::media( duplicate, false );
+    _standby.set_media( _standby_media );
+    _standby.play();
+    _standby_id = _preload_id;
+}
+
+bool player::switch_to_preloaded( unsigned idx )
+{
+    if( !_gapless )
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock( _standby_guard );
+
+        if( invalid_item_id == _standby_id || _playlist.id( idx ) != _standby_id )
+            return false;
+
+        switch( _standby.get_state() ) {
+        case libvlc_Opening:
+        case libvlc_Buffering:
+        case libvlc_Playing:
+        case libvlc_Paused:
+            break;
+        default:
+            return false;
+        }
+
+        //audio/video tracks are chosen per media anyway
+        copy_player_settings( _player.get_mp(), _standby.get_mp() );
+
+        swap_player( &_standby );
+
+        _switched_id = _standby_id;
+        _switched_media = std::move( _standby_media );
+        _standby_id = invalid_item_id;
+    }
+
+    _current_idx = idx;
+
+    //standby media player got its media while its events were not attached
+    libvlc_event_t e = libvlc_event_t();
+    e.type = libvlc_MediaPlayerMediaChanged;
+    e.p_obj = _player.get_mp();
+    e.u.media_player_media_changed.new_media = _switched_media.libvlc_media_t();
+    event_proxy( &e, this );
+
     _player.play();
+    watch_sub_items( _switched_media );
+
+    update_materialized();
+    //will stop previous media player, which is now standby one
+    prepare_preload();
+
+    return true;
 }
 
 void player::play()
@@ -385,7 +1286,7 @@ void player::play()
         //special case for empty playlist ( usually after clear_items() )
         _player.play();
     } else {
-        const unsigned sz = static_cast<unsigned>( _playlist.size() );
+        const unsigned sz = _playlist.size();
         int idx = _current_idx;
         if( idx < 0 )
             idx = 0;
@@ -413,23 +1314,17 @@ int player::find_valid_item( int start_from_idx, bool forward )
     if( !sz )
         return -1;
 
+    int idx = -1;
     if( forward ) {
         if( start_from_idx < 0 )
             start_from_idx = 0;
         else if( start_from_idx > sz )
             start_from_idx = sz;
 
-        for( int i = start_from_idx; i < sz; ++i ) {
-            if( !_playlist[i].disabled )
-                return i;
-        }
+        idx = _playlist.find_enabled( start_from_idx, sz );
 
-        if( mode_loop == _mode ) {
-            for( int i = 0; i < start_from_idx; ++i ) {
-                if( !_playlist[i].disabled )
-                    return i;
-            }
-        }
+        if( idx < 0 && mode_loop == _mode )
+            idx = _playlist.find_enabled( 0, start_from_idx );
     } else {
         if( start_from_idx > sz - 1 )
             start_from_idx = sz - 1;
@@ -437,19 +1332,13 @@ int player::find_valid_item( int start_from_idx, bool forward )
         if( start_from_idx < -1 )
             start_from_idx = -1;
 
-        for( int i = start_from_idx; i >= 0; --i ) {
-            if( !_playlist[i].disabled )
-                return i;
-        }
+        idx = _playlist.rfind_enabled( 0, start_from_idx + 1 );
 
-        if( mode_loop == _mode ) {
-            for( int i = sz - 1; i > start_from_idx; --i ) {
-                if( !_playlist[i].disabled )
-                    return i;
-            }
-        }
+        if( idx < 0 && mode_loop == _mode )
+            idx = _playlist.rfind_enabled( start_from_idx + 1, sz );
     }
-    return -1;
+
+    return idx;
 }
 
 void player::prev()
@@ -457,89 +1346,382 @@ void player::prev()
     if( _playlist.empty() )
         return;
 
-    internal_play( find_valid_item( _current_idx - 1, false ) );
+    if( mode_shuffle == _mode )
+        internal_play( shuffle_prev() );
+    else
+        internal_play( find_valid_item( _current_idx - 1, false ) );
 }
 
-void player::get_media_sub_items( const vlc::media& media, playlist_t* out )
+void player::watch_sub_items( vlc::media media )
 {
-    assert( out );
-
-    if( !media || !out )
+    if( media == _watched_media )
         return;
 
-    libvlc_media_list_t* sub_items = libvlc_media_subitems( media.libvlc_media_t() );
-    if( !sub_items )
-        return;
+    //detach could wait for running callback,
+    //so it should be done without _sub_items_guard locked
+    if( _watched_media ) {
+        libvlc_event_detach( libvlc_media_event_manager( _watched_media.libvlc_media_t() ),
+                             libvlc_MediaSubItemAdded, sub_item_added_proxy, this );
+    }
 
-    libvlc_media_list_lock( sub_items );
+    {
+        std::lock_guard<std::mutex> lock( _sub_items_guard );
+        _sub_items.clear();
+    }
 
-    int sub_items_count =
-        std::min<unsigned>( libvlc_media_list_count( sub_items ), PLAYLIST_MAX_SIZE );
+    _watched_media = std::move( media );
+
+    if( !_watched_media )
+        return;
 
-    for( int i = 0; i < sub_items_count; ++i ) {
-        libvlc_media_t* sub_item = libvlc_media_list_item_at_index( sub_items, i );
-        if( sub_item ) {
-            playlist_item item = { vlc::media( sub_item, false ), false, std::string() };
-            out->push_back( item );
+    libvlc_event_attach( libvlc_media_event_manager( _watched_media.libvlc_media_t() ),
+                         libvlc_MediaSubItemAdded, sub_item_added_proxy, this );
+
+    //media parsed before it was watched (f.e. replayed one)
+    //doesn't report its sub items again, so existing ones are taken.
+    //Snapshot is taken after attach, so it has items reported before it
+    std::vector<vlc::media> sub_items;
+    _watched_media.sub_items( &sub_items );
+    if( sub_items.size() > PLAYLIST_MAX_SIZE )
+        sub_items.resize( PLAYLIST_MAX_SIZE );
+
+    std::lock_guard<std::mutex> lock( _sub_items_guard );
+    for( vlc::media& m: _sub_items ) {
+        if( sub_items.size() < PLAYLIST_MAX_SIZE &&
+            std::find( sub_items.begin(), sub_items.end(), m ) == sub_items.end() )
+        {
+            sub_items.push_back( std::move( m ) );
         }
     }
+    _sub_items.swap( sub_items );
+}
 
-    libvlc_media_list_unlock( sub_items );
+void player::sub_item_added_proxy( const libvlc_event_t* e, void* param )
+{
+    player* p = static_cast<player*>( param );
+    libvlc_media_t* sub_item = e->u.media_subitem_added.new_child;
+    if( !p || !sub_item )
+        return;
 
-    libvlc_media_list_release( sub_items );
+    std::lock_guard<std::mutex> lock( p->_sub_items_guard );
+    if( p->_sub_items.size() < PLAYLIST_MAX_SIZE )
+        p->_sub_items.push_back( vlc::media( sub_item, true ) );
 }
 
-bool player::try_expand_current()
+bool player::expand_current()
 {
-    vlc::media current_media;
-    std::string current_media_data;
-    if( _current_idx < 0 || unsigned( _current_idx ) >= _playlist.size() ) {
-        current_media = _player.current_media();
-    } else {
-        current_media = _playlist[_current_idx].media;
-        current_media_data = _playlist[_current_idx].data;
+    if( !_watched_media )
+        return false;
+
+    const bool has_current =
+        _current_idx >= 0 && unsigned( _current_idx ) < _playlist.size();
+
+    //sub items are only for media which is in media player now
+    if( _player.current_media() != _watched_media ||
+        ( has_current && !is_loaded( _current_idx ) ) )
+    {
+        return false;
+    }
+
+    std::vector<vlc::media> sub_items;
+    {
+        std::lock_guard<std::mutex> lock( _sub_items_guard );
+        sub_items.swap( _sub_items );
     }
 
-    playlist_t sub_items;
-    get_media_sub_items( current_media, &sub_items );
+    if( sub_items.empty() )
+        return false;
 
     if( _playlist.size() > PLAYLIST_MAX_SIZE - sub_items.size() ) {
         sub_items.resize( PLAYLIST_MAX_SIZE - _playlist.size() );
     }
 
-    if( !current_media_data.empty() ) {
-        for( auto& i: sub_items ) {
-            i.data = current_media_data;
-        }
-    }
+    if( sub_items.empty() )
+        return false;
 
-    if( !sub_items.empty() ) {
-        playlist_it insert_it;
-        if( _current_idx < 0 ) {
-            insert_it = _playlist.begin();
-        } else if( unsigned( _current_idx ) >= _playlist.size() ) {
-            insert_it = _playlist.end();
-        } else {
-            insert_it = _playlist.erase( _playlist.begin() + _current_idx );
-        }
-        _current_idx = static_cast<int>( insert_it - _playlist.begin() );
-        _playlist.insert( insert_it, sub_items.begin(), sub_items.end() );
-        return true;
+    std::string current_media_data;
+    unsigned insert_idx;
+    if( _current_idx < 0 ) {
+        insert_idx = 0;
+    } else if( !has_current ) {
+        insert_idx = _playlist.size();
+    } else {
+        insert_idx = _current_idx;
+        current_media_data = _playlist.data( insert_idx );
+        shuffle_pool_erase( insert_idx, 1 );
+        _playlist.erase( insert_idx );
     }
+    _current_idx = static_cast<int>( insert_idx );
+    _playlist.insert( insert_idx,
+                      sub_items.data(), static_cast<unsigned>( sub_items.size() ),
+                      current_media_data );
 
-    return false;
+    return true;
 }
 
 void player::next()
 {
-    bool expanded = try_expand_current();
+    bool expanded = expand_current();
 
     if( _playlist.empty() )
         return;
 
     internal_play(
-        find_valid_item(
-            expanded ? _current_idx : _current_idx + 1, true ) );
+        expanded ?
+            find_valid_item( _current_idx, true ) :
+            next_item_idx( true ) );
+}
+
+int player::next_item_idx( bool advance )
+{
+    if( mode_shuffle == _mode )
+        return shuffle_next( advance );
+
+    return find_valid_item( _current_idx + 1, true );
+}
+
+void player::shuffle_reset()
+{
+    _shuffle_valid = false;
+    _shuffle_pool.clear();
+    _shuffle_pool_index.clear();
+    _shuffle_available = 0;
+    _shuffle_enabled = 0;
+    _shuffle_last_id = invalid_item_id;
+    _shuffle_history.clear();
+    _shuffle_pos = -1;
+}
+
+void player::shuffle_sync_pool()
+{
+    if( !_shuffle_valid ) {
+        //new round, every enabled item is in pool
+        std::vector<playlist_item_id_t> disabled;
+        _shuffle_pool.clear();
+        _shuffle_pool_index.clear();
+        _playlist.ids( &_shuffle_pool, &disabled );
+        _shuffle_available = _shuffle_enabled =
+            static_cast<uint32_t>( _shuffle_pool.size() );
+        _shuffle_pool.insert( _shuffle_pool.end(), disabled.begin(), disabled.end() );
+
+        ++_shuffle_round;
+        const shuffle_entry entry = { 0, _shuffle_round - 1 };
+        _shuffle_pool_index.reserve( _shuffle_pool.size() );
+        for( uint32_t i = 0; i < _shuffle_pool.size(); ++i ) {
+            _shuffle_pool_index.emplace( _shuffle_pool[i], entry ).first->second.pos = i;
+        }
+
+        _shuffle_last_id = _playlist.last_id();
+        _shuffle_valid = true;
+        return;
+    }
+
+    //items are never given id lower than last one,
+    //so only ids after _shuffle_last_id could be new
+    for( ; _shuffle_last_id < _playlist.last_id(); ) {
+        const playlist_item_id_t id = ++_shuffle_last_id;
+        const int idx = _playlist.find_id( id );
+        if( idx < 0 )
+            continue;
+
+        shuffle_pool_add( id, _playlist.is_disabled( idx ) );
+    }
+}
+
+void player::shuffle_pool_swap( uint32_t pos1, uint32_t pos2 )
+{
+    if( pos1 == pos2 )
+        return;
+
+    const playlist_item_id_t tmp_id = _shuffle_pool[pos1];
+    _shuffle_pool[pos1] = _shuffle_pool[pos2];
+    _shuffle_pool[pos2] = tmp_id;
+
+    _shuffle_pool_index[_shuffle_pool[pos1]].pos = pos1;
+    _shuffle_pool_index[_shuffle_pool[pos2]].pos = pos2;
+}
+
+void player::shuffle_pool_add( playlist_item_id_t id, bool disabled )
+{
+    //added as disabled one, and then enabled
+    const uint32_t pos = static_cast<uint32_t>( _shuffle_pool.size() );
+    const shuffle_entry entry = { pos, _shuffle_round - 1 };
+    _shuffle_pool_index.emplace( id, entry );
+    _shuffle_pool.push_back( id );
+
+    if( !disabled )
+        shuffle_pool_set_disabled( id, false );
+}
+
+void player::shuffle_pool_remove( playlist_item_id_t id )
+{
+    auto it = _shuffle_pool_index.find( id );
+    if( it == _shuffle_pool_index.end() )
+        return;
+
+    shuffle_pool_set_disabled( id, true );
+    shuffle_pool_swap( it->second.pos, static_cast<uint32_t>( _shuffle_pool.size() - 1 ) );
+
+    _shuffle_pool.pop_back();
+    _shuffle_pool_index.erase( it );
+}
+
+void player::shuffle_pool_erase( unsigned idx, unsigned count )
+{
+    if( !_shuffle_valid )
+        return;
+
+    for( unsigned i = idx; i < idx + count; ++i )
+        shuffle_pool_remove( _playlist.id( i ) );
+}
+
+void player::shuffle_pool_set_disabled( playlist_item_id_t id, bool disabled )
+{
+    auto it = _shuffle_pool_index.find( id );
+    if( it == _shuffle_pool_index.end() )
+        return;
+
+    const uint32_t pos = it->second.pos;
+    if( disabled ) {
+        if( pos >= _shuffle_enabled )
+            return;
+
+        //moved to the end of not drawn, then drawn, then disabled range
+        if( pos < _shuffle_available )
+            shuffle_pool_swap( pos, --_shuffle_available );
+        shuffle_pool_swap( it->second.pos, --_shuffle_enabled );
+    } else {
+        if( pos < _shuffle_enabled )
+            return;
+
+        shuffle_pool_swap( pos, _shuffle_enabled++ );
+
+        //item enabled again is not drawn twice in the same round
+        if( it->second.drawn_round != _shuffle_round )
+            shuffle_pool_swap( it->second.pos, _shuffle_available++ );
+    }
+}
+
+void player::shuffle_mark_drawn( playlist_item_id_t id )
+{
+    auto it = _shuffle_pool_index.find( id );
+    if( it == _shuffle_pool_index.end() )
+        return;
+
+    it->second.drawn_round = _shuffle_round;
+
+    if( it->second.pos < _shuffle_available )
+        shuffle_pool_swap( it->second.pos, --_shuffle_available );
+}
+
+void player::shuffle_sync_current()
+{
+    shuffle_sync_pool();
+
+    const playlist_item_id_t current_id = current_item_id();
+    if( invalid_item_id == current_id ) {
+        _shuffle_history.clear();
+        _shuffle_pos = -1;
+        return;
+    }
+
+    if( _shuffle_pos >= 0 && _shuffle_history[_shuffle_pos] == current_id )
+        return;
+
+    //current was changed not by next()/prev() (f.e. by play( idx )),
+    //so history continues from it
+    _shuffle_history.resize( _shuffle_pos + 1 );
+    _shuffle_history.push_back( current_id );
+    _shuffle_pos = static_cast<int>( _shuffle_history.size() - 1 );
+    shuffle_mark_drawn( current_id );
+}
+
+int player::shuffle_draw( playlist_item_id_t current_id, bool advance )
+{
+    if( !_shuffle_available ) {
+        //nothing to play
+        if( !_shuffle_enabled )
+            return -1;
+
+        //new round, every enabled item is not drawn again,
+        //except current one, which is played already
+        ++_shuffle_round;
+        _shuffle_available = _shuffle_enabled;
+        shuffle_mark_drawn( current_id );
+
+        //current is the only enabled item
+        if( !_shuffle_available )
+            return _playlist.find_id( current_id );
+    }
+
+    std::uniform_int_distribution<uint32_t> pick( 0, _shuffle_available - 1 );
+    const playlist_item_id_t id = _shuffle_pool[pick( _shuffle_rng )];
+    if( advance )
+        shuffle_mark_drawn( id );
+
+    const int idx = _playlist.find_id( id );
+    assert( idx >= 0 && !_playlist.is_disabled( idx ) );
+
+    return idx;
+}
+
+int player::shuffle_next( bool advance )
+{
+    shuffle_sync_current();
+
+    return shuffle_forward( current_item_id(), advance );
+}
+
+int player::shuffle_forward( playlist_item_id_t current_id, bool advance )
+{
+    //replay history forward first (after prev() calls)
+    for( size_t p = _shuffle_pos + 1; p < _shuffle_history.size(); ) {
+        const int idx = _playlist.find_id( _shuffle_history[p] );
+        if( idx >= 0 && !_playlist.is_disabled( idx ) ) {
+            if( advance ) {
+                _shuffle_pos = static_cast<int>( p );
+                shuffle_mark_drawn( _shuffle_history[p] );
+            }
+            return idx;
+        }
+        _shuffle_history.erase( _shuffle_history.begin() + p );
+    }
+
+    const int idx = shuffle_draw( current_id, advance );
+    if( idx < 0 )
+        return -1;
+
+    //history is only for prev(), so there is no need to keep it all
+    enum { MAX_SHUFFLE_HISTORY = 1024 };
+    if( _shuffle_history.size() >= MAX_SHUFFLE_HISTORY && _shuffle_pos > 0 ) {
+        const int drop = std::min<int>( _shuffle_pos, MAX_SHUFFLE_HISTORY / 2 );
+        _shuffle_history.erase( _shuffle_history.begin(),
+                                _shuffle_history.begin() + drop );
+        _shuffle_pos -= drop;
+    }
+
+    _shuffle_history.push_back( _playlist.id( idx ) );
+    if( advance )
+        _shuffle_pos = static_cast<int>( _shuffle_history.size() - 1 );
+
+    return idx;
+}
+
+int player::shuffle_prev()
+{
+    shuffle_sync_current();
+
+    for( int p = _shuffle_pos - 1; p >= 0; --p ) {
+        const int idx = _playlist.find_id( _shuffle_history[p] );
+        if( idx >= 0 && !_playlist.is_disabled( idx ) ) {
+            _shuffle_pos = p;
+            return idx;
+        }
+        _shuffle_history.erase( _shuffle_history.begin() + p );
+        --_shuffle_pos;
+    }
+
+    return -1;
 }
 
 playback_mode_e player::get_playback_mode()
@@ -549,6 +1731,9 @@ playback_mode_e player::get_playback_mode()
 
 void player::set_playback_mode( playback_mode_e m )
 {
+    if( mode_shuffle == m && m != _mode )
+        shuffle_reset();
+
     _mode = m;
 }
 
@@ -557,9 +1742,28 @@ void player::swap( player* p )
     if( this == p )
         return;
 
+    //preload jobs use _player, so they should be done before swap
+    reset_preload();
+    p->reset_preload();
+
     player_core::swap( p );
 
-    _playlist.swap( p->_playlist );
+    watch_sub_items( vlc::media() );
+    p->watch_sub_items( vlc::media() );
+
+    _playlist.swap( &p->_playlist );
+    _materialized.swap( p->_materialized );
+    shuffle_reset();
+    p->shuffle_reset();
+
+    const playlist_item_id_t tmp_switched_id = p->_switched_id;
+    p->_switched_id = _switched_id;
+    _switched_id = tmp_switched_id;
+
+    _switched_media.swap( &p->_switched_media );
+
+    watch_sub_items( _player.current_media() );
+    p->watch_sub_items( p->_player.current_media() );
 
     const playback_mode_e tmp_mode = p->_mode;
     p->_mode = _mode;
@@ -28,7 +28,13 @@
 #include <stdint.h>
 
 #include <vector>
-#include <deque>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <memory>
+#include <future>
 
 #include "callbacks_holder.h"
 #include "vlc_basic_player.h"
@@ -36,6 +42,8 @@
 #include "vlc_audio.h"
 #include "vlc_video.h"
 #include "vlc_subtitles.h"
+#include "vlc_playlist_storage.h"
+#include "vlc_player_state.h"
 
 namespace vlc
 {
@@ -44,7 +52,9 @@ namespace vlc
         mode_single = 0, //default. playback will stop on current item end (or error).
         mode_normal, //same as mode_single by default.
         mode_loop, //have effect only to next()/prev() calls
-        mode_last = mode_loop,
+        mode_shuffle, //next() plays random item not played in current round,
+                      //prev() returns to previously played ones
+        mode_last = mode_shuffle,
     };
 
     struct media_player_events_callback
@@ -52,30 +62,109 @@ namespace vlc
         virtual void media_player_event( const libvlc_event_t* e ) = 0;
     };
 
+    typedef unsigned media_player_events_mask_t;
+
+    //every media player event (libvlc_MediaPlayer*) has own bit in mask,
+    //all other events (libvlc_MediaList*) are delivered regardless of mask
+    inline media_player_events_mask_t media_player_event_mask( libvlc_event_type_t e )
+    {
+        return ( e >= libvlc_MediaPlayerMediaChanged &&
+                 e < libvlc_MediaPlayerMediaChanged + 32 ) ?
+            1u << ( e - libvlc_MediaPlayerMediaChanged ) :
+            ~media_player_events_mask_t( 0 );
+    }
+
+    const media_player_events_mask_t all_media_player_events =
+        ~media_player_events_mask_t( 0 );
+
+    class event_dispatcher;
+    class event_trace_recorder;
+    class instance_manager;
+
+    //see player_core::snapshot
+    struct player_snapshot
+    {
+        player_snapshot()
+            : state( libvlc_NothingSpecial ),
+              time( 0 ), interpolated_time( 0 ), position( 0.f ), length( 0 ),
+              rate( 1.f ), fps( 0.f ), volume( 0 ), muted( false ),
+              audio_track( -1 ), video_track( -1 ), subtitles_track( -1 ) {}
+
+        libvlc_state_t state;
+        libvlc_time_t  time;
+        //same as time if state cache is disabled
+        libvlc_time_t  interpolated_time;
+        float          position;
+        libvlc_time_t  length;
+        float          rate;
+        float          fps;
+
+        unsigned       volume;
+        bool           muted;
+
+        //-1 if there is no active track
+        int            audio_track;
+        int            video_track;
+        int            subtitles_track;
+    };
+
     class player_core
         : protected callbacks_holder<media_player_events_callback>
     {
         typedef callbacks_holder<media_player_events_callback> callbacks_holder;
 
+    public:
+        typedef callbacks_holder::handle callback_handle;
+
     public:
         player_core();
         ~player_core();
 
         virtual bool open( libvlc_instance_t* );
+        //opens with instance of least loaded shard of manager,
+        //instance is given back to manager on close
+        bool open( instance_manager* );
         virtual void close();
+        //same as close, but media player is stopped and released on reaper thread
+        virtual void close_async();
 
         bool is_open() const { return _player.is_open(); }
 
-        libvlc_state_t get_state() { return _player.get_state(); }
+        libvlc_state_t get_state();
         bool is_playing() { return libvlc_Playing == get_state(); }
 
+        //if enabled, get_state/is_playing and playback() get_time/get_position/get_length
+        //return values maintained from media player events instead of asking libvlc
+        //(which takes libvlc internal locks), so they are cheap to poll from any thread
+        void set_state_cache( bool enable );
+        bool is_state_cache_enabled() const
+            { return _state_cache_enabled; }
+        const player_state& cached_state() const
+            { return _cached_state; }
+
+        //if enabled, audio/video/subtitles tracks tables are kept between queries
+        //and invalidated on media player events which usually accompany
+        //tracks changes (libvlc doesn't report them),
+        //otherwise they are fetched from libvlc on every query
+        void set_tracks_cache( bool enable );
+        bool is_tracks_cache_enabled() const
+            { return _tracks_cache_enabled; }
+
+        //fills s with current state in one pass
+        //(state, time, position, length and rate are taken from state cache if enabled)
+        void snapshot( player_snapshot* s );
+
         vlc::media current_media()
             { return _player.current_media(); }
+        bool current_media( vlc::media* out )
+            { return _player.current_media( out ); }
 
         virtual void play() = 0;
         void pause();
         void togglePause();
         void stop();
+        //see basic_player::stop_async
+        void stop_async();
 
         vlc::basic_player& basic_player() { return _player; }
 
@@ -87,24 +176,87 @@ namespace vlc
         libvlc_media_player_t* get_mp() const
             { return _player.get_mp(); }
 
-        //events will come from worker thread
-        void register_callback( media_player_events_callback* ) override;
-        void unregister_callback( media_player_events_callback* ) override;
+        //events will come from worker thread.
+        //libvlc will be asked only for events required by any of registered callbacks.
+        //register/unregister are allowed from inside of callback.
+        callback_handle register_callback( media_player_events_callback*,
+                                           media_player_events_mask_t events_mask =
+                                               all_media_player_events ) override;
+        void unregister_callback( const callback_handle& ) override;
+        using callbacks_holder::unregister_callback;
+
+        //if set (and running), events will come from dispatcher thread
+        //instead of libvlc internal thread. 0 - deliver events synchronously
+        void set_event_dispatcher( event_dispatcher* );
+        event_dispatcher* get_event_dispatcher() const
+            { return _event_dispatcher; }
+
+        //every event received from libvlc will be written to recorder
+        //(use event_trace_player to replay them later). 0 - stop recording
+        void set_event_recorder( event_trace_recorder* recorder )
+            { _event_recorder = recorder; }
 
         void swap( player_core* );
 
     private:
+        friend class event_dispatcher;
+        friend class event_trace_player;
+
         void event( const libvlc_event_t* );
+        //attaches internal events and events of currently registered callbacks
+        //(or detaches all if events are disabled by detach_events).
+        //Only one thread applies mask at a time, and it does it without
+        //_attach_guard locked (libvlc could wait for running event callback,
+        //which could register/unregister callback itself): if other thread
+        //is applying right now, it will apply the newest mask once more instead.
+        //if wait is true, returns only when mask of the moment of call is applied
+        void sync_events_attach( bool wait );
+        //should be called by applying thread only
+        void apply_events_mask( media_player_events_mask_t events_mask );
+        void apply_events_mask( libvlc_media_player_t* mp,
+                                media_player_events_mask_t events_mask );
+        //events required regardless of callbacks (by tracks and state caches)
+        media_player_events_mask_t internal_events_mask() const;
+        void invalidate_tracks();
+        //attaches/detaches all events of current media player
+        void attach_events();
+        void detach_events();
+        void internal_close( bool async );
 
     protected:
         static void event_proxy( const libvlc_event_t* , void* );
         virtual void events_attach( bool attach );
 
+        //exchanges libvlc media player with p,
+        //events are reattached to new one
+        void swap_player( vlc::basic_player* p );
+
     protected:
         libvlc_instance_t* _libvlc_instance;
         vlc::basic_player  _player;
 
     private:
+        //manager _libvlc_instance was acquired from
+        instance_manager* _instance_manager;
+        //guards attach requests state below
+        std::mutex _attach_guard;
+        std::condition_variable _attach_applied_cond;
+        bool _events_enabled;
+        bool _attach_applying;
+        uint64_t _attach_requested;
+        uint64_t _attach_applied;
+        //media player events currently attached to _attached_mp
+        //(only applying thread touches them)
+        libvlc_media_player_t* _attached_mp;
+        media_player_events_mask_t _attached_events;
+        std::atomic<event_dispatcher*> _event_dispatcher;
+        std::atomic<event_trace_recorder*> _event_recorder;
+
+        std::atomic<bool>  _state_cache_enabled;
+        player_state       _cached_state;
+
+        std::atomic<bool>  _tracks_cache_enabled;
+
         vlc::playback      _playback;
         vlc::video         _video;
         vlc::audio         _audio;
@@ -125,10 +277,10 @@ namespace vlc
             { return add_media( mrl_or_path, optc, optv, 0, 0, is_path ); }
         int add_media( const char* mrl_or_path, bool is_path = false )
             { return add_media( mrl_or_path, 0, 0, is_path ); }
-        int add_media( const char* mrl_or_path,
-                       unsigned optc, const char** optv,
-                       unsigned trusted_optc, const char** trusted_optv,
-                       bool is_path = false );
+        virtual int add_media( const char* mrl_or_path,
+                               unsigned optc, const char** optv,
+                               unsigned trusted_optc, const char** trusted_optv,
+                               bool is_path = false );
 
         virtual int add_media( const vlc::media& media ) = 0;
 
@@ -138,6 +290,9 @@ namespace vlc
         virtual void clear_items() = 0;
 
         virtual vlc::media get_media( unsigned idx ) = 0;
+        //writes to caller's media, returns false (with out cleared) if there is no item
+        bool get_media( unsigned idx, vlc::media* out )
+            { *out = get_media( idx ); return *out; }
 
         virtual int find_media_index( const vlc::media& ) = 0;
 
@@ -162,8 +317,12 @@ namespace vlc
     {
     public:
         player();
+        ~player();
 
+        using playlist_player_core::open;
+        bool open( libvlc_instance_t* inst ) override;
         void close() override;
+        void close_async() override;
 
         void play() override;
         bool play( unsigned idx ) override;
@@ -174,6 +333,13 @@ namespace vlc
         void set_playback_mode( playback_mode_e m ) override;
 
         using playlist_player_core::add_media;
+        //items added by mrl keep only mrl and options,
+        //media is created when item becomes current or next one
+        //(or when get_media is called for it) and released afterwards
+        int add_media( const char* mrl_or_path,
+                       unsigned optc, const char** optv,
+                       unsigned trusted_optc, const char** trusted_optv,
+                       bool is_path = false ) override;
         int add_media( const vlc::media& media ) override;
 
         void advance_item( unsigned idx, int count ) override;
@@ -182,7 +348,10 @@ namespace vlc
         void clear_items() override;
         unsigned item_count() override;
 
+        using playlist_player_core::get_media;
         vlc::media get_media( unsigned idx ) override;
+        //after gapless switch current_media() is duplicate of item media,
+        //it's mapped to that item as well
         int find_media_index( const vlc::media& ) override;
 
         int current_item() override;
@@ -194,30 +363,183 @@ namespace vlc
         void set_item_data( unsigned idx, const std::string& ) override;
         const std::string& get_item_data( unsigned idx ) override;
 
+        //item id stays valid while item is in playlist,
+        //regardless of item position changes.
+        //by id lookup of item is O(1), but item position (as well as any
+        //access by index) is O(log n), since playlist order is kept as treap
+        playlist_item_id_t add_media_item( const vlc::media& media );
+        playlist_item_id_t item_id( unsigned idx );
+        //O(log n), -1 if there is no item with id
+        int item_index( playlist_item_id_t id );
+        playlist_item_id_t current_item_id();
+
+        bool play_by_id( playlist_item_id_t id );
+        bool delete_item_by_id( playlist_item_id_t id );
+        void disable_item_by_id( playlist_item_id_t id, bool disable );
+        void set_item_data_by_id( playlist_item_id_t id, const std::string& );
+
+        //bulk operations, every one is applied to playlist at once.
+        //items added from mrls are lazy, all with the same options;
+        //returns index of first added item, or -1 if nothing was added
+        int add_media_items( const char* const* mrls_or_paths, unsigned count,
+                             unsigned optc, const char** optv,
+                             bool is_path = false );
+        int add_media_items( const vlc::media* media, unsigned count );
+        bool delete_items( unsigned idx, unsigned count );
+        //item order[i] becomes item i,
+        //order should contain every index of playlist exactly once
+        bool reorder_items( const unsigned* order, unsigned count );
+
+        //if enabled, when current item comes to last preload_time ms,
+        //next item is opened (and left paused) in standby media player,
+        //and switching to it just exchanges media players.
+        //only video output to window (xwindow/hwnd/nsobject) is moved
+        //to standby media player, so don't use it with vmem.
+        void set_gapless( bool gapless );
+        bool is_gapless() const
+            { return _gapless; }
+        void set_preload_time( libvlc_time_t ms )
+            { _preload_time = ms; }
+        libvlc_time_t preload_time() const
+            { return _preload_time; }
+
         void swap( player* );
 
     private:
-        struct playlist_item
+        //starts collecting sub items of media (usually current one)
+        //as they are added by libvlc while it's playing
+        void watch_sub_items( vlc::media media );
+        static void sub_item_added_proxy( const libvlc_event_t*, void* );
+        //replaces current item with collected sub items
+        bool expand_current();
+        void internal_play( int idx );
+        int find_valid_item( int start_from_idx, bool forward );
+
+        //item which next() will play, or -1
+        int next_item_idx( bool advance );
+
+        //mode_shuffle: items are drawn from pool at random one by one
+        //(incremental Fisher-Yates), drawn ones are appended to history,
+        //so prev()/next() could walk it back and forth.
+        //Pool follows items disable/enable/delete, so every draw is single pick
+        void shuffle_reset();
+        //adds to pool items inserted since last call
+        void shuffle_sync_pool();
+        void shuffle_pool_add( playlist_item_id_t id, bool disabled );
+        void shuffle_pool_remove( playlist_item_id_t id );
+        //removes items [idx, idx + count) from pool, should be called before erase
+        void shuffle_pool_erase( unsigned idx, unsigned count );
+        void shuffle_pool_set_disabled( playlist_item_id_t id, bool disabled );
+        void shuffle_pool_swap( uint32_t pos1, uint32_t pos2 );
+        //item is played in current round
+        void shuffle_mark_drawn( playlist_item_id_t id );
+        //makes current item current history entry
+        void shuffle_sync_current();
+        //if not advance, drawn item is only peeked
+        //and stays in pool until it's really played
+        int shuffle_draw( playlist_item_id_t current_id, bool advance );
+        int shuffle_next( bool advance );
+        //item after history entry of current_id
+        //(which could be already deleted), drawn from pool if history ends
+        int shuffle_forward( playlist_item_id_t current_id, bool advance );
+        int shuffle_prev();
+
+        //materializes media of lazy item
+        vlc::media item_media( unsigned idx );
+        //releases media of lazy items except current and next ones,
+        //and creates media for next one in advance
+        void update_materialized();
+
+        void close_preload( bool async );
+        //should be called with _standby_guard locked
+        void stop_standby();
+        //remembers next item as the one to preload
+        void prepare_preload();
+        //also waits preload job if it's running right now
+        void reset_preload();
+        //called from libvlc thread, only posts preload job to reaper
+        void preload_event( const libvlc_event_t* );
+        //opens next item in _standby, executed on reaper thread
+        void preload();
+        //makes preloaded item current if it is item idx
+        bool switch_to_preloaded( unsigned idx );
+        //if item idx media is already set to _player
+        bool is_loaded( unsigned idx );
+
+        class preload_watcher : public media_player_events_callback
         {
-            vlc::media media;
-            bool disabled;
-            std::string data;
-        };
+        public:
+            explicit preload_watcher( player* owner )
+                : _owner( owner ) {}
 
-        typedef std::deque<playlist_item> playlist_t;
-        typedef playlist_t::iterator playlist_it;
-        typedef playlist_t::const_iterator playlist_cit;
+            void media_player_event( const libvlc_event_t* e ) override
+                { _owner->preload_event( e ); }
 
-    private:
-        static void get_media_sub_items( const vlc::media& media, playlist_t* out );
-        bool try_expand_current();
-        void internal_play( int idx );
-        int find_valid_item( int start_from_idx, bool forward );
+        private:
+            player* _owner;
+        };
 
     private:
-        playback_mode_e _mode;
-        playlist_t _playlist;
-        int        _current_idx;
+        playback_mode_e  _mode;
+        playlist_storage _playlist;
+        int              _current_idx;
+
+        //lazy items with media created
+        std::vector<playlist_item_id_t> _materialized;
+
+        std::atomic<bool>          _gapless;
+        std::atomic<libvlc_time_t> _preload_time;
+        preload_watcher            _preload_watcher;
+        callback_handle            _preload_watcher_handle;
+
+        //guards everything related to _standby
+        std::mutex         _standby_guard;
+        vlc::basic_player  _standby;
+        //next item and its media
+        playlist_item_id_t _preload_id;
+        vlc::media         _preload_media;
+        //item loaded to _standby (with media duplicated)
+        playlist_item_id_t _standby_id;
+        vlc::media         _standby_media;
+
+        //preload job keeps weak reference to it,
+        //so job posted before reset_preload does nothing
+        struct preload_token {};
+        std::shared_ptr<preload_token> _preload_token;
+        std::shared_future<void>       _preload_job;
+
+        //item which was switched to from _standby
+        //(_player has duplicate of its media)
+        playlist_item_id_t _switched_id;
+        vlc::media         _switched_media;
+
+        struct shuffle_entry
+        {
+            uint32_t pos;
+            //round item was drawn last time in
+            uint32_t drawn_round;
+        };
+
+        bool                _shuffle_valid;
+        //ids of all items: [0, _shuffle_available) are not drawn in current round,
+        //[_shuffle_available, _shuffle_enabled) are drawn already,
+        //[_shuffle_enabled, size) are disabled
+        std::vector<playlist_item_id_t> _shuffle_pool;
+        std::unordered_map<playlist_item_id_t, shuffle_entry> _shuffle_pool_index;
+        uint32_t            _shuffle_available;
+        uint32_t            _shuffle_enabled;
+        uint32_t            _shuffle_round;
+        //last item id which was considered for pool
+        playlist_item_id_t  _shuffle_last_id;
+        std::vector<playlist_item_id_t> _shuffle_history;
+        //position of current item in _shuffle_history, or -1
+        int                 _shuffle_pos;
+        std::minstd_rand    _shuffle_rng;
+
+        vlc::media              _watched_media;
+        //sub items of _watched_media collected from libvlc thread
+        std::mutex              _sub_items_guard;
+        std::vector<vlc::media> _sub_items;
     };
 }
 
@@ -0,0 +1,245 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "vlc_player_actor.h"
+
+#include <cassert>
+
+using namespace vlc;
+
+player_actor::player_actor( vlc::player* player )
+    : _player( player ), _head( &_stub_command ), _tail( &_stub_command ),
+      _sleeping( false ), _state( state_stopped ), _posting( 0 )
+{
+    assert( _player );
+}
+
+player_actor::~player_actor()
+{
+    stop();
+}
+
+bool player_actor::start()
+{
+    std::lock_guard<std::mutex> lock( _control_guard );
+
+    if( state_running == _state )
+        return true;
+
+    _state = state_running;
+    _thread = std::thread( &player_actor::run, this );
+
+    return true;
+}
+
+void player_actor::stop()
+{
+    std::lock_guard<std::mutex> lock( _control_guard );
+
+    if( state_running != _state )
+        return;
+
+    _state = state_stopping;
+    {
+        std::lock_guard<std::mutex> sleep_lock( _sleep_guard );
+        _sleeping = false;
+        _wakeup.notify_one();
+    }
+
+    _thread.join();
+
+    //post() which saw state_running could still be pushing,
+    //every later one will not push anymore
+    while( _posting )
+        std::this_thread::yield();
+
+    //commands which were pushed while thread was exiting,
+    //deleting them breaks their promises
+    while( command* c = pop() )
+        delete c;
+
+    _state = state_stopped;
+}
+
+bool player_actor::is_running() const
+{
+    return state_running == _state;
+}
+
+void player_actor::push( command* c )
+{
+    c->next.store( nullptr, std::memory_order_relaxed );
+    command* prev = _head.exchange( c, std::memory_order_acq_rel );
+    //between exchange and this store queue is "broken",
+    //pop() will just wait for producer to finish
+    prev->next.store( c, std::memory_order_release );
+
+    if( _sleeping.exchange( false ) ) {
+        std::lock_guard<std::mutex> lock( _sleep_guard );
+        _wakeup.notify_one();
+    }
+}
+
+player_actor::command* player_actor::pop()
+{
+    command* tail = _tail;
+    command* next = tail->next.load( std::memory_order_acquire );
+
+    if( &_stub_command == tail ) {
+        if( !next )
+            return nullptr;
+
+        _tail = next;
+        tail = next;
+        next = next->next.load( std::memory_order_acquire );
+    }
+
+    if( next ) {
+        _tail = next;
+        return tail;
+    }
+
+    if( tail != _head.load( std::memory_order_acquire ) )
+        return nullptr; //producer is in the middle of push
+
+    //tail is the last command, so put stub after it to detach it
+    push( &_stub_command );
+
+    next = tail->next.load( std::memory_order_acquire );
+    if( next ) {
+        _tail = next;
+        return tail;
+    }
+
+    return nullptr;
+}
+
+bool player_actor::empty() const
+{
+    return &_stub_command == _tail &&
+           !_stub_command.next.load( std::memory_order_acquire ) &&
+           &_stub_command == _head.load( std::memory_order_acquire );
+}
+
+void player_actor::run()
+{
+    for( ;; ) {
+        if( command* c = pop() ) {
+            c->execute( *_player );
+            delete c;
+            continue;
+        }
+
+        if( !empty() ) {
+            //some producer didn't finish push yet
+            std::this_thread::yield();
+            continue;
+        }
+
+        if( state_running != _state )
+            break;
+
+        _sleeping = true;
+        if( !empty() || state_running != _state ) {
+            _sleeping = false;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock( _sleep_guard );
+        _wakeup.wait( lock, [this] () { return !_sleeping; } );
+    }
+}
+
+std::future<void> player_actor::play()
+{
+    return post( [] ( vlc::player& p ) { p.play(); } );
+}
+
+std::future<bool> player_actor::play( unsigned idx )
+{
+    return post( [idx] ( vlc::player& p ) { return p.play( idx ); } );
+}
+
+std::future<void> player_actor::pause()
+{
+    return post( [] ( vlc::player& p ) { p.pause(); } );
+}
+
+std::future<void> player_actor::togglePause()
+{
+    return post( [] ( vlc::player& p ) { p.togglePause(); } );
+}
+
+std::future<void> player_actor::stop_playback()
+{
+    return post( [] ( vlc::player& p ) { p.stop(); } );
+}
+
+std::future<void> player_actor::next()
+{
+    return post( [] ( vlc::player& p ) { p.next(); } );
+}
+
+std::future<void> player_actor::prev()
+{
+    return post( [] ( vlc::player& p ) { p.prev(); } );
+}
+
+std::future<int> player_actor::add_media( const std::string& mrl_or_path, bool is_path )
+{
+    return post( [mrl_or_path, is_path] ( vlc::player& p ) {
+        return p.add_media( mrl_or_path.c_str(), is_path );
+    } );
+}
+
+std::future<bool> player_actor::delete_item( unsigned idx )
+{
+    return post( [idx] ( vlc::player& p ) { return p.delete_item( idx ); } );
+}
+
+std::future<void> player_actor::clear_items()
+{
+    return post( [] ( vlc::player& p ) { p.clear_items(); } );
+}
+
+std::future<unsigned> player_actor::item_count()
+{
+    return post( [] ( vlc::player& p ) { return p.item_count(); } );
+}
+
+std::future<int> player_actor::current_item()
+{
+    return post( [] ( vlc::player& p ) { return p.current_item(); } );
+}
+
+std::future<void> player_actor::set_current( unsigned idx )
+{
+    return post( [idx] ( vlc::player& p ) { p.set_current( idx ); } );
+}
+
+std::future<void> player_actor::set_playback_mode( playback_mode_e m )
+{
+    return post( [m] ( vlc::player& p ) { p.set_playback_mode( m ); } );
+}
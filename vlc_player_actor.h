@@ -0,0 +1,161 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <utility>
+
+#include "vlc_player.h"
+
+namespace vlc
+{
+    //serializes access to vlc::player:
+    //commands could be posted from any thread without locks
+    //(multiple producers single consumer intrusive queue),
+    //and are executed one by one on actor own thread.
+    //Player should not be used directly while actor is running.
+    //Don't wait for returned futures from libvlc callbacks:
+    //commands like stop() could wait for libvlc thread.
+    class player_actor
+    {
+    public:
+        explicit player_actor( vlc::player* player );
+        ~player_actor();
+
+        bool start();
+        //commands already posted are executed before actor thread exits,
+        //commands which lost the race with stop() are never executed
+        //and their futures get broken_promise
+        void stop();
+
+        bool is_running() const;
+
+        //f( vlc::player& ) will be called on actor thread
+        template<typename F>
+        auto post( F&& f ) -> std::future<decltype( f( std::declval<vlc::player&>() ) )>;
+
+        std::future<void> play();
+        std::future<bool> play( unsigned idx );
+        std::future<void> pause();
+        std::future<void> togglePause();
+        std::future<void> stop_playback();
+        std::future<void> next();
+        std::future<void> prev();
+
+        std::future<int> add_media( const std::string& mrl_or_path, bool is_path = false );
+        std::future<bool> delete_item( unsigned idx );
+        std::future<void> clear_items();
+        std::future<unsigned> item_count();
+
+        std::future<int> current_item();
+        std::future<void> set_current( unsigned idx );
+        std::future<void> set_playback_mode( playback_mode_e m );
+
+    private:
+        struct command
+        {
+            command() : next( nullptr ) {}
+            virtual ~command() {}
+            //not pure, since _stub_command is never executed
+            virtual void execute( vlc::player& ) {}
+
+            std::atomic<command*> next;
+        };
+
+        template<typename R>
+        struct task_command : public command
+        {
+            template<typename F>
+            explicit task_command( F&& f )
+                : task( std::forward<F>( f ) ) {}
+
+            void execute( vlc::player& p ) override
+                { task( p ); }
+
+            std::packaged_task<R( vlc::player& )> task;
+        };
+
+        //safe to call from any thread
+        void push( command* );
+        //should be called only from actor thread
+        command* pop();
+        bool empty() const;
+
+        void run();
+
+    private:
+        vlc::player* _player;
+
+        //queue is linked list from _tail to _head,
+        //_stub is used to never leave it empty
+        command _stub_command;
+        std::atomic<command*> _head;
+        command* _tail;
+
+        //actor thread waits for commands only when _sleeping is set
+        std::atomic<bool> _sleeping;
+        std::mutex _sleep_guard;
+        std::condition_variable _wakeup;
+
+        enum state_e {
+            state_stopped,
+            state_running,
+            state_stopping,
+        };
+
+        //serializes start() and stop()
+        std::mutex _control_guard;
+        std::thread _thread;
+        std::atomic<state_e> _state;
+        //count of post() calls which could push right now,
+        //stop() waits for them before it drops not executed commands
+        std::atomic<unsigned> _posting;
+    };
+
+    template<typename F>
+    auto player_actor::post( F&& f ) -> std::future<decltype( f( std::declval<vlc::player&>() ) )>
+    {
+        typedef decltype( f( std::declval<vlc::player&>() ) ) result_t;
+
+        std::unique_ptr<task_command<result_t> > c(
+            new task_command<result_t>( std::forward<F>( f ) ) );
+        std::future<result_t> result = c->task.get_future();
+
+        //command destroyed without execution breaks promise
+        ++_posting;
+        if( state_running == _state )
+            push( c.release() );
+        --_posting;
+
+        return result;
+    }
+}
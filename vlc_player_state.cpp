@@ -0,0 +1,224 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "vlc_player_state.h"
+
+#include <chrono>
+
+using namespace vlc;
+
+player_state::player_state()
+    : _state( libvlc_NothingSpecial ), _time( 0 ), _position( 0.f ), _length( 0 ),
+      _clock_seq( 0 ), _clock_base( 0 ), _clock_stamp( 0 ), _clock_rate( 1.f ),
+      _clock_running( false )
+{
+}
+
+int64_t player_state::now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+libvlc_time_t player_state::interpolated_time() const
+{
+    libvlc_time_t base;
+    int64_t stamp;
+    float rate;
+    bool running;
+
+    for( ;; ) {
+        const unsigned seq = _clock_seq.load( std::memory_order_acquire );
+        if( seq & 1 )
+            continue;
+
+        base = _clock_base.load( std::memory_order_relaxed );
+        stamp = _clock_stamp.load( std::memory_order_relaxed );
+        rate = _clock_rate.load( std::memory_order_relaxed );
+        running = _clock_running.load( std::memory_order_relaxed );
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if( _clock_seq.load( std::memory_order_relaxed ) == seq )
+            break;
+    }
+
+    const libvlc_time_t time = extrapolate( base, stamp, rate, running, now_us() );
+
+    const libvlc_time_t length = _length;
+    if( length > 0 && time > length )
+        return length;
+
+    return time;
+}
+
+libvlc_time_t player_state::extrapolate( libvlc_time_t base, int64_t stamp,
+                                         float rate, bool running, int64_t now )
+{
+    if( !running )
+        return base;
+
+    libvlc_time_t elapsed =
+        static_cast<libvlc_time_t>( ( now - stamp ) * rate / 1000 );
+    if( elapsed < 0 )
+        elapsed = 0;
+    else if( elapsed > MAX_EXTRAPOLATION )
+        elapsed = MAX_EXTRAPOLATION;
+
+    return base + elapsed;
+}
+
+libvlc_time_t player_state::clock_time( int64_t now ) const
+{
+    return extrapolate( _clock_base.load( std::memory_order_relaxed ),
+                        _clock_stamp.load( std::memory_order_relaxed ),
+                        _clock_rate.load( std::memory_order_relaxed ),
+                        _clock_running.load( std::memory_order_relaxed ),
+                        now );
+}
+
+void player_state::set_clock( libvlc_time_t time, int64_t stamp, float rate, bool running )
+{
+    const unsigned seq = _clock_seq.load( std::memory_order_relaxed );
+    _clock_seq.store( seq + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    _clock_base.store( time < 0 ? 0 : time, std::memory_order_relaxed );
+    _clock_stamp.store( stamp, std::memory_order_relaxed );
+    _clock_rate.store( rate, std::memory_order_relaxed );
+    _clock_running.store( running, std::memory_order_relaxed );
+
+    _clock_seq.store( seq + 2, std::memory_order_release );
+}
+
+void player_state::reset( libvlc_media_player_t* mp )
+{
+    std::lock_guard<std::mutex> lock( _clock_guard );
+
+    if( !mp ) {
+        _state = libvlc_NothingSpecial;
+        _time = 0;
+        _position = 0.f;
+        _length = 0;
+        set_clock( 0, now_us(), 1.f, false );
+        return;
+    }
+
+    _state = libvlc_media_player_get_state( mp );
+
+    const libvlc_time_t t = libvlc_media_player_get_time( mp );
+    _time = t < 0 ? 0 : t;
+
+    const float p = libvlc_media_player_get_position( mp );
+    _position = p < 0 ? 0.f : p;
+
+    const libvlc_time_t l = libvlc_media_player_get_length( mp );
+    _length = l < 0 ? 0 : l;
+
+    set_clock( _time, now_us(), libvlc_media_player_get_rate( mp ),
+               libvlc_Playing == _state );
+}
+
+void player_state::seek( libvlc_time_t time )
+{
+    std::lock_guard<std::mutex> lock( _clock_guard );
+
+    set_clock( time, now_us(),
+               _clock_rate.load( std::memory_order_relaxed ),
+               _clock_running.load( std::memory_order_relaxed ) );
+}
+
+void player_state::set_rate( float rate )
+{
+    std::lock_guard<std::mutex> lock( _clock_guard );
+
+    const int64_t now = now_us();
+    set_clock( clock_time( now ), now, rate,
+               _clock_running.load( std::memory_order_relaxed ) );
+}
+
+void player_state::update( const libvlc_event_t* e )
+{
+    std::lock_guard<std::mutex> lock( _clock_guard );
+
+    const int64_t now = now_us();
+    const float rate = _clock_rate.load( std::memory_order_relaxed );
+
+    switch( e->type ) {
+    case libvlc_MediaPlayerMediaChanged:
+        _state = libvlc_NothingSpecial;
+        _time = 0;
+        _position = 0.f;
+        _length = 0;
+        set_clock( 0, now, rate, false );
+        break;
+    case libvlc_MediaPlayerNothingSpecial:
+        _state = libvlc_NothingSpecial;
+        set_clock( clock_time( now ), now, rate, false );
+        break;
+    case libvlc_MediaPlayerOpening:
+        _state = libvlc_Opening;
+        set_clock( clock_time( now ), now, rate, false );
+        break;
+    case libvlc_MediaPlayerPlaying:
+        _state = libvlc_Playing;
+        set_clock( clock_time( now ), now, rate, true );
+        break;
+    case libvlc_MediaPlayerPaused:
+        _state = libvlc_Paused;
+        set_clock( clock_time( now ), now, rate, false );
+        break;
+    case libvlc_MediaPlayerStopped:
+        _state = libvlc_Stopped;
+        _time = 0;
+        _position = 0.f;
+        set_clock( 0, now, rate, false );
+        break;
+    case libvlc_MediaPlayerEndReached:
+        _state = libvlc_Ended;
+        set_clock( clock_time( now ), now, rate, false );
+        break;
+    case libvlc_MediaPlayerEncounteredError:
+        _state = libvlc_Error;
+        set_clock( clock_time( now ), now, rate, false );
+        break;
+    case libvlc_MediaPlayerTimeChanged: {
+        const libvlc_time_t t = e->u.media_player_time_changed.new_time;
+        _time = t < 0 ? 0 : t;
+        set_clock( _time, now, rate,
+                   _clock_running.load( std::memory_order_relaxed ) );
+        break;
+    }
+    case libvlc_MediaPlayerPositionChanged: {
+        const float p = e->u.media_player_position_changed.new_position;
+        _position = p < 0 ? 0.f : p;
+        break;
+    }
+    case libvlc_MediaPlayerLengthChanged: {
+        const libvlc_time_t l = e->u.media_player_length_changed.new_length;
+        _length = l < 0 ? 0 : l;
+        break;
+    }
+    }
+}
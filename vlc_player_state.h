@@ -0,0 +1,93 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+
+#include <vlc/vlc.h>
+
+namespace vlc
+{
+    //media player state maintained from libvlc events,
+    //could be read from any thread without calling into libvlc
+    class player_state
+    {
+    public:
+        player_state();
+
+        libvlc_state_t state() const { return _state; }
+        libvlc_time_t time() const { return _time; }
+        float position() const { return _position; }
+        libvlc_time_t length() const { return _length; }
+        float rate() const { return _clock_rate; }
+
+        //time extrapolated from last reported one with monotonic clock
+        //and current rate while playing (but not more than
+        //MAX_EXTRAPOLATION ms ahead, and not beyond length)
+        libvlc_time_t interpolated_time() const;
+
+        //reads current values from libvlc, mp could be 0
+        void reset( libvlc_media_player_t* mp );
+        //called from libvlc thread
+        void update( const libvlc_event_t* );
+
+        //libvlc doesn't report these, so they should be called
+        //by whoever seeks or changes rate to resync interpolated time
+        void seek( libvlc_time_t time );
+        void set_rate( float rate );
+
+        enum {
+            MAX_EXTRAPOLATION = 1000,
+        };
+
+    private:
+        static int64_t now_us();
+        static libvlc_time_t extrapolate( libvlc_time_t base, int64_t stamp,
+                                          float rate, bool running, int64_t now );
+
+        //should be called with _clock_guard locked
+        libvlc_time_t clock_time( int64_t now ) const;
+        void set_clock( libvlc_time_t time, int64_t stamp, float rate, bool running );
+
+    private:
+        std::atomic<libvlc_state_t> _state;
+        std::atomic<libvlc_time_t>  _time;
+        std::atomic<float>          _position;
+        std::atomic<libvlc_time_t>  _length;
+
+        //interpolation base, written under _clock_guard,
+        //read lock free with _clock_seq (odd while write is in progress)
+        std::mutex                 _clock_guard;
+        std::atomic<unsigned>      _clock_seq;
+        std::atomic<libvlc_time_t> _clock_base;
+        std::atomic<int64_t>       _clock_stamp;
+        std::atomic<float>         _clock_rate;
+        std::atomic<bool>          _clock_running;
+    };
+}
@@ -0,0 +1,735 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "vlc_playlist_storage.h"
+
+#include <cassert>
+
+#include <algorithm>
+
+using namespace vlc;
+
+////////////////////////////////////////////////////////////////////////////////
+// class vlc::playlist_storage
+////////////////////////////////////////////////////////////////////////////////
+
+playlist_storage::playlist_storage()
+    : _root( NO_SLOT ), _priority_seed( 2463534242u ),
+      _next_id( invalid_item_id + 1 )
+{
+    clear();
+}
+
+playlist_storage::~playlist_storage()
+{
+    clear();
+}
+
+void playlist_storage::reserve( unsigned size )
+{
+    _order.reserve( size );
+    _media.reserve( size );
+    _ids.reserve( size );
+    _item_sources.reserve( size );
+    _data.reserve( size );
+    _media_index.reserve( size );
+    _id_index.reserve( size );
+}
+
+void playlist_storage::clear()
+{
+    //media of free slots is already released
+    for( ::libvlc_media_t* m: _media ) {
+        if( m )
+            libvlc_media_release( m );
+    }
+
+    _order.clear();
+    _root = NO_SLOT;
+    _free_slots.clear();
+    _media.clear();
+    _ids.clear();
+    _item_sources.clear();
+    _sources.clear();
+    _free_sources.clear();
+    _data.clear();
+    _media_index.clear();
+    _id_index.clear();
+
+    _strings.clear();
+    _free_strings.clear();
+    _string_ids.clear();
+
+    auto it = _string_ids.emplace( std::string(), EMPTY_STRING_ID ).first;
+    const interned_string empty = { &it->first, 0 };
+    _strings.push_back( empty );
+}
+
+void playlist_storage::swap( playlist_storage* s )
+{
+    _order.swap( s->_order );
+    std::swap( _root, s->_root );
+    std::swap( _priority_seed, s->_priority_seed );
+    _free_slots.swap( s->_free_slots );
+    _media.swap( s->_media );
+    _ids.swap( s->_ids );
+    _item_sources.swap( s->_item_sources );
+    _sources.swap( s->_sources );
+    _free_sources.swap( s->_free_sources );
+    _data.swap( s->_data );
+    _strings.swap( s->_strings );
+    _free_strings.swap( s->_free_strings );
+    _string_ids.swap( s->_string_ids );
+    _media_index.swap( s->_media_index );
+    std::swap( _next_id, s->_next_id );
+    _id_index.swap( s->_id_index );
+}
+
+playlist_storage::string_id_t playlist_storage::intern( const std::string& str )
+{
+    if( str.empty() )
+        return EMPTY_STRING_ID;
+
+    auto it = _string_ids.find( str );
+    if( it != _string_ids.end() )
+        return it->second;
+
+    string_id_t id;
+    if( _free_strings.empty() ) {
+        id = static_cast<string_id_t>( _strings.size() );
+        _strings.push_back( interned_string() );
+    } else {
+        id = _free_strings.back();
+        _free_strings.pop_back();
+    }
+
+    it = _string_ids.emplace( str, id ).first;
+    _strings[id].str = &it->first;
+    _strings[id].refs = 0;
+
+    return id;
+}
+
+void playlist_storage::add_string_ref( string_id_t id )
+{
+    if( id != EMPTY_STRING_ID )
+        ++_strings[id].refs;
+}
+
+void playlist_storage::release_string( string_id_t id )
+{
+    if( id == EMPTY_STRING_ID )
+        return;
+
+    interned_string& s = _strings[id];
+    assert( s.refs > 0 );
+    if( --s.refs )
+        return;
+
+    _string_ids.erase( *s.str );
+    s.str = nullptr;
+    _free_strings.push_back( id );
+}
+
+void playlist_storage::set_data( unsigned idx, const std::string& data )
+{
+    const slot_t slot = slot_at( idx );
+
+    const string_id_t id = intern( data );
+    add_string_ref( id );
+    release_string( _data[slot] );
+    _data[slot] = id;
+}
+
+playlist_storage::string_id_t playlist_storage::intern_options( unsigned optc, const char** optv )
+{
+    std::string options;
+    for( unsigned i = 0; i < optc; ++i ) {
+        options += optv[i];
+        options += '\0';
+    }
+
+    return intern( options );
+}
+
+std::vector<const char*> playlist_storage::split_options( const std::string& options )
+{
+    std::vector<const char*> optv;
+    for( size_t pos = 0; pos < options.size(); pos = options.find( '\0', pos ) + 1 )
+        optv.push_back( options.c_str() + pos );
+
+    return optv;
+}
+
+uint32_t playlist_storage::next_priority()
+{
+    //xorshift32
+    uint32_t x = _priority_seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    _priority_seed = x;
+
+    return x & PRIORITY_MASK;
+}
+
+void playlist_storage::update_node( slot_t node )
+{
+    order_node& n = _order[node];
+
+    n.size = 1;
+    n.enabled = ( n.priority & DISABLED_BIT ) ? 0 : 1;
+
+    if( n.left != NO_SLOT ) {
+        n.size += _order[n.left].size;
+        n.enabled += _order[n.left].enabled;
+        _order[n.left].parent = node;
+    }
+    if( n.right != NO_SLOT ) {
+        n.size += _order[n.right].size;
+        n.enabled += _order[n.right].enabled;
+        _order[n.right].parent = node;
+    }
+}
+
+void playlist_storage::split( slot_t node, unsigned count, slot_t* left, slot_t* right )
+{
+    if( NO_SLOT == node ) {
+        *left = *right = NO_SLOT;
+        return;
+    }
+
+    order_node& n = _order[node];
+    const unsigned left_size = subtree_size( n.left );
+    if( count <= left_size ) {
+        split( n.left, count, left, &n.left );
+        *right = node;
+    } else {
+        split( n.right, count - left_size - 1, &n.right, right );
+        *left = node;
+    }
+    update_node( node );
+}
+
+playlist_storage::slot_t playlist_storage::merge( slot_t left, slot_t right )
+{
+    if( NO_SLOT == left )
+        return right;
+    if( NO_SLOT == right )
+        return left;
+
+    if( priority( left ) > priority( right ) ) {
+        const slot_t merged = merge( _order[left].right, right );
+        _order[left].right = merged;
+        update_node( left );
+        return left;
+    } else {
+        const slot_t merged = merge( left, _order[right].left );
+        _order[right].left = merged;
+        update_node( right );
+        return right;
+    }
+}
+
+playlist_storage::slot_t playlist_storage::build( const slot_t* slots, unsigned count )
+{
+    if( 1 == count ) {
+        const slot_t node = slots[0];
+        _order[node].left = _order[node].right = _order[node].parent = NO_SLOT;
+        update_node( node );
+        return node;
+    }
+
+    //cartesian tree by priorities: every new node goes to the end
+    //of right spine of tree built so far
+    std::vector<slot_t> spine;
+    for( unsigned i = 0; i < count; ++i ) {
+        const slot_t node = slots[i];
+
+        //nodes popped from spine will not get new children anymore
+        slot_t last = NO_SLOT;
+        while( !spine.empty() && priority( spine.back() ) < priority( node ) ) {
+            last = spine.back();
+            spine.pop_back();
+            update_node( last );
+        }
+
+        _order[node].left = last;
+        _order[node].right = NO_SLOT;
+        if( !spine.empty() )
+            _order[spine.back()].right = node;
+        spine.push_back( node );
+    }
+
+    for( auto it = spine.rbegin(); it != spine.rend(); ++it )
+        update_node( *it );
+
+    if( spine.empty() )
+        return NO_SLOT;
+
+    _order[spine.front()].parent = NO_SLOT;
+    return spine.front();
+}
+
+void playlist_storage::collect( slot_t node, std::vector<slot_t>* slots ) const
+{
+    std::vector<slot_t> stack;
+    while( node != NO_SLOT || !stack.empty() ) {
+        while( node != NO_SLOT ) {
+            stack.push_back( node );
+            node = _order[node].left;
+        }
+
+        node = stack.back();
+        stack.pop_back();
+        slots->push_back( node );
+        node = _order[node].right;
+    }
+}
+
+playlist_storage::slot_t playlist_storage::slot_at( unsigned pos ) const
+{
+    assert( pos < size() );
+
+    slot_t node = _root;
+    for( ;; ) {
+        const order_node& n = _order[node];
+        const unsigned left_size = subtree_size( n.left );
+        if( pos < left_size ) {
+            node = n.left;
+        } else if( pos == left_size ) {
+            return node;
+        } else {
+            pos -= left_size + 1;
+            node = n.right;
+        }
+    }
+}
+
+unsigned playlist_storage::position( slot_t node ) const
+{
+    unsigned pos = subtree_size( _order[node].left );
+    for( slot_t parent = _order[node].parent; parent != NO_SLOT;
+         node = parent, parent = _order[parent].parent )
+    {
+        if( _order[parent].right == node )
+            pos += subtree_size( _order[parent].left ) + 1;
+    }
+
+    return pos;
+}
+
+unsigned playlist_storage::enabled_before( unsigned pos ) const
+{
+    unsigned enabled = 0;
+    for( slot_t node = _root; node != NO_SLOT; ) {
+        const order_node& n = _order[node];
+        const unsigned left_size = subtree_size( n.left );
+        if( pos <= left_size ) {
+            node = n.left;
+        } else {
+            enabled += subtree_enabled( n.left ) + ( is_slot_disabled( node ) ? 0 : 1 );
+            pos -= left_size + 1;
+            node = n.right;
+        }
+    }
+
+    return enabled;
+}
+
+unsigned playlist_storage::enabled_at( unsigned number ) const
+{
+    assert( number < subtree_enabled( _root ) );
+
+    unsigned pos = 0;
+    slot_t node = _root;
+    for( ;; ) {
+        const order_node& n = _order[node];
+        const unsigned left_enabled = subtree_enabled( n.left );
+        if( number < left_enabled ) {
+            node = n.left;
+            continue;
+        }
+
+        const unsigned own = is_slot_disabled( node ) ? 0 : 1;
+        if( own && number == left_enabled )
+            return pos + subtree_size( n.left );
+
+        number -= left_enabled + own;
+        pos += subtree_size( n.left ) + 1;
+        node = n.right;
+    }
+}
+
+playlist_storage::slot_t playlist_storage::alloc_slot( string_id_t data )
+{
+    slot_t slot;
+    if( _free_slots.empty() ) {
+        slot = static_cast<slot_t>( _order.size() );
+        _order.push_back( order_node() );
+        _media.push_back( nullptr );
+        _ids.push_back( invalid_item_id );
+        _item_sources.push_back( NO_SOURCE );
+        _data.push_back( EMPTY_STRING_ID );
+    } else {
+        slot = _free_slots.back();
+        _free_slots.pop_back();
+    }
+
+    order_node& n = _order[slot];
+    n.left = n.right = n.parent = NO_SLOT;
+    n.priority = next_priority();
+    n.size = n.enabled = 1;
+
+    _ids[slot] = _next_id++;
+    _id_index.emplace( _ids[slot], slot );
+
+    add_string_ref( data );
+    _data[slot] = data;
+
+    return slot;
+}
+
+void playlist_storage::free_slot( slot_t slot )
+{
+    if( ::libvlc_media_t* m = _media[slot] ) {
+        unindex_media( slot );
+        _media[slot] = nullptr;
+        libvlc_media_release( m );
+    }
+
+    _id_index.erase( _ids[slot] );
+    _ids[slot] = invalid_item_id;
+
+    if( _item_sources[slot] != NO_SOURCE ) {
+        free_source( _item_sources[slot] );
+        _item_sources[slot] = NO_SOURCE;
+    }
+
+    release_string( _data[slot] );
+    _data[slot] = EMPTY_STRING_ID;
+
+    _free_slots.push_back( slot );
+}
+
+playlist_storage::source_id_t playlist_storage::alloc_source()
+{
+    if( _free_sources.empty() ) {
+        const media_source source = { std::string(), EMPTY_STRING_ID, EMPTY_STRING_ID, false };
+        _sources.push_back( source );
+        return static_cast<source_id_t>( _sources.size() - 1 );
+    }
+
+    const source_id_t id = _free_sources.back();
+    _free_sources.pop_back();
+
+    return id;
+}
+
+void playlist_storage::free_source( source_id_t id )
+{
+    media_source& source = _sources[id];
+    std::string().swap( source.mrl_or_path );
+    release_string( source.options );
+    source.options = EMPTY_STRING_ID;
+    release_string( source.trusted_options );
+    source.trusted_options = EMPTY_STRING_ID;
+
+    if( id + 1 == _sources.size() )
+        _sources.pop_back();
+    else
+        _free_sources.push_back( id );
+}
+
+void playlist_storage::insert_slots( unsigned pos, const slot_t* slots, unsigned count )
+{
+    assert( pos <= size() );
+
+    for( unsigned i = 0; i < count; ++i ) {
+        if( _media[slots[i]] )
+            index_media( slots[i] );
+    }
+
+    const slot_t inserted = build( slots, count );
+    if( pos == size() ) {
+        //appending doesn't need split
+        _root = merge( _root, inserted );
+    } else {
+        slot_t left, right;
+        split( _root, pos, &left, &right );
+        _root = merge( merge( left, inserted ), right );
+    }
+    _order[_root].parent = NO_SLOT;
+}
+
+void playlist_storage::insert( unsigned pos,
+                               const vlc::media* media, unsigned count,
+                               const std::string& data )
+{
+    if( !count )
+        return;
+
+    const string_id_t data_id = intern( data );
+
+    std::vector<slot_t> slots( count );
+    for( unsigned i = 0; i < count; ++i ) {
+        slots[i] = alloc_slot( data_id );
+
+        ::libvlc_media_t* m = media[i].libvlc_media_t();
+        assert( m );
+        libvlc_media_retain( m );
+        _media[slots[i]] = m;
+    }
+
+    insert_slots( pos, slots.data(), count );
+}
+
+void playlist_storage::insert_lazy( unsigned pos,
+                                    const char* const* mrls_or_paths, unsigned count,
+                                    unsigned optc, const char** optv,
+                                    unsigned trusted_optc, const char** trusted_optv,
+                                    bool is_path )
+{
+    if( !count )
+        return;
+
+    const string_id_t options = intern_options( optc, optv );
+    const string_id_t trusted_options = intern_options( trusted_optc, trusted_optv );
+
+    std::vector<slot_t> slots( count );
+    for( unsigned i = 0; i < count; ++i ) {
+        slots[i] = alloc_slot( EMPTY_STRING_ID );
+
+        const source_id_t source_id = alloc_source();
+        _item_sources[slots[i]] = source_id;
+
+        media_source& source = _sources[source_id];
+        source.mrl_or_path = mrls_or_paths[i];
+        assert( !source.mrl_or_path.empty() );
+        source.options = options;
+        add_string_ref( options );
+        source.trusted_options = trusted_options;
+        add_string_ref( trusted_options );
+        source.is_path = is_path;
+    }
+
+    insert_slots( pos, slots.data(), count );
+}
+
+bool playlist_storage::materialize( unsigned idx, libvlc_instance_t* inst )
+{
+    const slot_t slot = slot_at( idx );
+
+    if( _media[slot] )
+        return true;
+
+    const source_id_t source_id = _item_sources[slot];
+    if( NO_SOURCE == source_id || !inst )
+        return false;
+
+    const media_source& source = _sources[source_id];
+    std::vector<const char*> optv = split_options( *_strings[source.options].str );
+    std::vector<const char*> trusted_optv = split_options( *_strings[source.trusted_options].str );
+
+    vlc::media media =
+        vlc::media::create_media( inst, source.mrl_or_path.c_str(),
+                                  static_cast<unsigned>( optv.size() ), optv.data(),
+                                  static_cast<unsigned>( trusted_optv.size() ), trusted_optv.data(),
+                                  source.is_path );
+    ::libvlc_media_t* m = media.libvlc_media_t();
+    if( !m )
+        return false;
+
+    libvlc_media_retain( m );
+    _media[slot] = m;
+    index_media( slot );
+
+    return true;
+}
+
+void playlist_storage::dematerialize( unsigned idx )
+{
+    const slot_t slot = slot_at( idx );
+
+    ::libvlc_media_t* m = _media[slot];
+    if( NO_SOURCE == _item_sources[slot] || !m )
+        return;
+
+    unindex_media( slot );
+    _media[slot] = nullptr;
+
+    libvlc_media_release( m );
+}
+
+void playlist_storage::set_disabled( unsigned idx, bool disabled )
+{
+    slot_t node = slot_at( idx );
+
+    if( disabled )
+        _order[node].priority |= DISABLED_BIT;
+    else
+        _order[node].priority &= ~DISABLED_BIT;
+
+    for( ; node != NO_SLOT; node = _order[node].parent )
+        update_node( node );
+}
+
+int playlist_storage::find_enabled( unsigned from, unsigned to ) const
+{
+    to = std::min( to, size() );
+    if( from >= to )
+        return -1;
+
+    const unsigned number = enabled_before( from );
+    if( number >= subtree_enabled( _root ) )
+        return -1;
+
+    const unsigned pos = enabled_at( number );
+    return pos < to ? static_cast<int>( pos ) : -1;
+}
+
+int playlist_storage::rfind_enabled( unsigned from, unsigned to ) const
+{
+    to = std::min( to, size() );
+    if( from >= to )
+        return -1;
+
+    const unsigned number = enabled_before( to );
+    if( !number )
+        return -1;
+
+    const unsigned pos = enabled_at( number - 1 );
+    return pos >= from ? static_cast<int>( pos ) : -1;
+}
+
+void playlist_storage::erase( unsigned idx, unsigned count )
+{
+    assert( idx + count <= size() );
+
+    if( !count )
+        return;
+
+    slot_t left, middle, right;
+    split( _root, idx, &left, &middle );
+    split( middle, count, &middle, &right );
+
+    std::vector<slot_t> slots;
+    slots.reserve( count );
+    collect( middle, &slots );
+    for( slot_t slot: slots )
+        free_slot( slot );
+
+    _root = merge( left, right );
+    if( _root != NO_SLOT )
+        _order[_root].parent = NO_SLOT;
+}
+
+void playlist_storage::move( unsigned idx, unsigned new_idx )
+{
+    assert( idx < size() && new_idx < size() );
+
+    if( idx == new_idx )
+        return;
+
+    slot_t left, item, right;
+    split( _root, idx, &left, &item );
+    split( item, 1, &item, &right );
+
+    split( merge( left, right ), new_idx, &left, &right );
+    _root = merge( merge( left, item ), right );
+    _order[_root].parent = NO_SLOT;
+}
+
+void playlist_storage::permute( const unsigned* order )
+{
+    const unsigned sz = size();
+
+    std::vector<slot_t> slots;
+    slots.reserve( sz );
+    collect( _root, &slots );
+
+    std::vector<slot_t> new_slots( sz );
+    for( unsigned i = 0; i < sz; ++i ) {
+        assert( order[i] < sz );
+        new_slots[i] = slots[order[i]];
+    }
+
+    _root = build( new_slots.data(), sz );
+}
+
+void playlist_storage::index_media( slot_t slot )
+{
+    _media_index.emplace( _media[slot], slot );
+}
+
+void playlist_storage::unindex_media( slot_t slot )
+{
+    auto range = _media_index.equal_range( _media[slot] );
+    for( auto it = range.first; it != range.second; ++it ) {
+        if( it->second == slot ) {
+            _media_index.erase( it );
+            return;
+        }
+    }
+
+    assert( false );
+}
+
+int playlist_storage::find( ::libvlc_media_t* media ) const
+{
+    auto range = _media_index.equal_range( media );
+
+    int idx = -1;
+    for( auto it = range.first; it != range.second; ++it ) {
+        const int pos = static_cast<int>( position( it->second ) );
+        if( idx < 0 || pos < idx )
+            idx = pos;
+    }
+
+    return idx;
+}
+
+int playlist_storage::find_id( playlist_item_id_t id ) const
+{
+    auto it = _id_index.find( id );
+
+    return ( _id_index.end() == it ) ? -1 : static_cast<int>( position( it->second ) );
+}
+
+void playlist_storage::ids( std::vector<playlist_item_id_t>* ids,
+                            std::vector<playlist_item_id_t>* disabled ) const
+{
+    std::vector<slot_t> slots;
+    slots.reserve( size() );
+    collect( _root, &slots );
+
+    ids->reserve( ids->size() + slots.size() );
+    for( slot_t slot: slots ) {
+        if( disabled && is_slot_disabled( slot ) )
+            disabled->push_back( _ids[slot] );
+        else
+            ids->push_back( _ids[slot] );
+    }
+}
@@ -0,0 +1,251 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#include "vlc_media.h"
+
+namespace vlc
+{
+    //stable item identifier, never reused during playlist_storage lifetime
+    typedef uint64_t playlist_item_id_t;
+    const playlist_item_id_t invalid_item_id = 0;
+
+    //compact storage of vlc::player items:
+    //every item property is kept in own array (struct of arrays) indexed by slot,
+    //slot of item never changes while item is in storage.
+    //items order is kept as implicit treap of slots, so insert, erase and move
+    //never shift items themselves and take O(log n) per item,
+    //access by index and index of item are O(log n) as well.
+    //media is kept as raw retained pointer, item data strings are interned,
+    //all indexes are 32 bit.
+    //lazy items keep only mrl and options until they are materialized.
+    class playlist_storage
+    {
+    public:
+        playlist_storage();
+        ~playlist_storage();
+
+        playlist_storage( const playlist_storage& ) = delete;
+        playlist_storage& operator= ( const playlist_storage& ) = delete;
+
+        unsigned size() const
+            { return subtree_size( _root ); }
+        bool empty() const
+            { return NO_SLOT == _root; }
+
+        void reserve( unsigned size );
+        void clear();
+        void swap( playlist_storage* );
+
+        //inserts count items with the same data before pos
+        void insert( unsigned pos,
+                     const vlc::media* media, unsigned count,
+                     const std::string& data );
+        void push_back( const vlc::media& media )
+            { insert( size(), &media, 1, std::string() ); }
+        //inserts count items which media will be created only on materialize,
+        //all with the same options
+        void insert_lazy( unsigned pos,
+                          const char* const* mrls_or_paths, unsigned count,
+                          unsigned optc, const char** optv,
+                          unsigned trusted_optc, const char** trusted_optv,
+                          bool is_path );
+        void erase( unsigned idx )
+            { erase( idx, 1 ); }
+        void erase( unsigned idx, unsigned count );
+        //moves item from idx to new_idx, items between are shifted
+        void move( unsigned idx, unsigned new_idx );
+        //item order[i] becomes item i, order should be permutation of [0, size)
+        void permute( const unsigned* order );
+
+        //could be 0 for lazy item which is not materialized
+        ::libvlc_media_t* libvlc_media( unsigned idx ) const
+            { return _media[slot_at( idx )]; }
+        vlc::media media( unsigned idx ) const
+            { return vlc::media( libvlc_media( idx ), true ); }
+
+        bool is_lazy( unsigned idx ) const
+            { return _item_sources[slot_at( idx )] != NO_SOURCE; }
+        //creates media of lazy item if it's not created yet,
+        //returns false if media can't be created
+        bool materialize( unsigned idx, libvlc_instance_t* );
+        //releases media of lazy item, it will be created again on materialize
+        void dematerialize( unsigned idx );
+
+        bool is_disabled( unsigned idx ) const
+            { return is_slot_disabled( slot_at( idx ) ); }
+        void set_disabled( unsigned idx, bool disabled );
+
+        //first/last not disabled item in [from, to), or -1
+        int find_enabled( unsigned from, unsigned to ) const;
+        int rfind_enabled( unsigned from, unsigned to ) const;
+
+        const std::string& data( unsigned idx ) const
+            { return *_strings[_data[slot_at( idx )]].str; }
+        void set_data( unsigned idx, const std::string& data );
+
+        //index of first item with media, or -1
+        int find( ::libvlc_media_t* ) const;
+
+        playlist_item_id_t id( unsigned idx ) const
+            { return _ids[slot_at( idx )]; }
+        //index of item with id, or -1
+        int find_id( playlist_item_id_t ) const;
+        bool contains_id( playlist_item_id_t id ) const
+            { return _id_index.find( id ) != _id_index.end(); }
+        //appends ids of all items in playlist order,
+        //if disabled is given, ids of disabled items are appended to it instead
+        void ids( std::vector<playlist_item_id_t>* ids,
+                  std::vector<playlist_item_id_t>* disabled = nullptr ) const;
+        //ids are given in ascending order,
+        //so every item inserted later has greater id
+        playlist_item_id_t last_id() const
+            { return _next_id - 1; }
+
+    private:
+        typedef uint32_t slot_t;
+        enum : slot_t { NO_SLOT = 0xFFFFFFFF };
+
+        typedef uint32_t string_id_t;
+        enum : string_id_t { EMPTY_STRING_ID = 0 };
+
+        typedef uint32_t source_id_t;
+        enum : source_id_t { NO_SOURCE = 0xFFFFFFFF };
+
+        //allocates slot for item without media, the slot is not in order yet
+        slot_t alloc_slot( string_id_t data );
+        //releases everything held by item in slot and makes slot free
+        void free_slot( slot_t );
+        source_id_t alloc_source();
+        void free_source( source_id_t );
+        //puts slots to order before pos and indexes their media
+        void insert_slots( unsigned pos, const slot_t* slots, unsigned count );
+
+        string_id_t intern( const std::string& );
+        //options are interned as one string, every option is terminated with '\0'
+        string_id_t intern_options( unsigned optc, const char** optv );
+        static std::vector<const char*> split_options( const std::string& );
+        void add_string_ref( string_id_t );
+        void release_string( string_id_t );
+
+        void index_media( slot_t );
+        //should be called before media will be removed from slot
+        void unindex_media( slot_t );
+
+        //implicit treap: node key is its position, i.e. count of nodes before it
+        uint32_t subtree_size( slot_t node ) const
+            { return NO_SLOT == node ? 0 : _order[node].size; }
+        uint32_t subtree_enabled( slot_t node ) const
+            { return NO_SLOT == node ? 0 : _order[node].enabled; }
+        uint32_t priority( slot_t node ) const
+            { return _order[node].priority & PRIORITY_MASK; }
+        bool is_slot_disabled( slot_t node ) const
+            { return ( _order[node].priority & DISABLED_BIT ) != 0; }
+        uint32_t next_priority();
+        //recalculates node counters from children and sets children parent
+        void update_node( slot_t node );
+        //first count nodes of tree go to left, the rest go to right
+        void split( slot_t node, unsigned count, slot_t* left, slot_t* right );
+        slot_t merge( slot_t left, slot_t right );
+        //builds tree of slots in given order in O(count)
+        slot_t build( const slot_t* slots, unsigned count );
+        //appends slots of tree in order
+        void collect( slot_t node, std::vector<slot_t>* slots ) const;
+        slot_t slot_at( unsigned pos ) const;
+        unsigned position( slot_t ) const;
+        //count of enabled items before pos
+        unsigned enabled_before( unsigned pos ) const;
+        //position of enabled item with given number
+        unsigned enabled_at( unsigned number ) const;
+
+    private:
+        enum : uint32_t {
+            DISABLED_BIT = 0x80000000,
+            PRIORITY_MASK = ~DISABLED_BIT,
+        };
+
+        struct order_node
+        {
+            slot_t left;
+            slot_t right;
+            slot_t parent;
+            //random treap priority, DISABLED_BIT is disabled flag of item
+            uint32_t priority;
+            //count of all and of not disabled items in subtree
+            uint32_t size;
+            uint32_t enabled;
+        };
+        std::vector<order_node> _order;
+        slot_t _root;
+        uint32_t _priority_seed;
+        std::vector<slot_t> _free_slots;
+
+        std::vector< ::libvlc_media_t*> _media;
+        std::vector<playlist_item_id_t> _ids;
+
+        //where to create media of lazy item from.
+        //only lazy items have source, so it's kept in side table
+        struct media_source
+        {
+            std::string mrl_or_path;
+            string_id_t options;
+            string_id_t trusted_options;
+            bool is_path;
+        };
+        //NO_SOURCE for not lazy items
+        std::vector<source_id_t> _item_sources;
+        std::vector<media_source> _sources;
+        std::vector<source_id_t> _free_sources;
+
+        std::vector<string_id_t> _data;
+
+        struct interned_string
+        {
+            //points to key in _string_ids
+            const std::string* str;
+            uint32_t refs;
+        };
+        std::vector<interned_string> _strings;
+        std::vector<string_id_t> _free_strings;
+        std::unordered_map<std::string, string_id_t> _string_ids;
+
+        //media -> slots of items with it.
+        //the same media is in several items only if it was added to playlist again
+        //after it was obtained with media(), so usually there is only one
+        std::unordered_multimap< ::libvlc_media_t*, slot_t> _media_index;
+
+        playlist_item_id_t _next_id;
+        //id -> slot
+        std::unordered_map<playlist_item_id_t, slot_t> _id_index;
+    };
+}
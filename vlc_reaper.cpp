@@ -0,0 +1,115 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "vlc_reaper.h"
+
+using namespace vlc;
+
+reaper::reaper()
+    : _busy( false ), _running( false ), _stopping( false )
+{
+}
+
+reaper::~reaper()
+{
+    {
+        std::lock_guard<std::mutex> lock( _guard );
+        _stopping = true;
+        _not_empty.notify_one();
+    }
+
+    if( _thread.joinable() )
+        _thread.join();
+}
+
+reaper& reaper::instance()
+{
+    //leaked intentionally: function local static would be destroyed at exit
+    //while other static objects (or other threads) could still post to it
+    static reaper* instance = new reaper;
+    return *instance;
+}
+
+std::shared_future<void> reaper::post( std::function<void()> job_func )
+{
+    job j;
+    j.func.swap( job_func );
+    std::shared_future<void> done = j.done.get_future().share();
+
+    std::unique_lock<std::mutex> lock( _guard );
+
+    if( _stopping && !_running ) {
+        //there is nobody to execute it anymore
+        lock.unlock();
+        j.func();
+        j.done.set_value();
+        return done;
+    }
+
+    if( !_running ) {
+        _running = true;
+        _thread = std::thread( &reaper::run, this );
+    }
+
+    _jobs.push_back( std::move( j ) );
+    _not_empty.notify_one();
+
+    return done;
+}
+
+unsigned reaper::pending() const
+{
+    std::lock_guard<std::mutex> lock( _guard );
+
+    return static_cast<unsigned>( _jobs.size() ) + ( _busy ? 1 : 0 );
+}
+
+void reaper::run()
+{
+    std::unique_lock<std::mutex> lock( _guard );
+
+    for( ;; ) {
+        _not_empty.wait( lock, [this] () {
+            return !_jobs.empty() || _stopping;
+        } );
+
+        //remaining jobs are done even if stopping
+        if( _jobs.empty() ) {
+            _running = false;
+            break;
+        }
+
+        job j = std::move( _jobs.front() );
+        _jobs.pop_front();
+        _busy = true;
+
+        lock.unlock();
+        j.func();
+        j.done.set_value();
+        lock.lock();
+
+        _busy = false;
+    }
+}
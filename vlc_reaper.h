@@ -0,0 +1,79 @@
+/*******************************************************************************
+* Copyright © 2015, Sergey Radionov <rsatom_gmail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*   1. Redistributions of source code must retain the above copyright notice,
+*      this list of conditions and the following disclaimer.
+*   2. Redistributions in binary form must reproduce the above copyright notice,
+*      this list of conditions and the following disclaimer in the documentation
+*      and/or other materials provided with the distribution.
+
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+* OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+* PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+* OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace vlc
+{
+    //stops and releases libvlc objects on own thread,
+    //so threads calling *_async methods don't wait for libvlc teardown.
+    //Jobs are executed in the same order they were posted.
+    class reaper
+    {
+    public:
+        reaper();
+        //waits until all posted jobs are done
+        ~reaper();
+
+        //reaper used by *_async methods of wrappers,
+        //it's never destroyed, so could be used from static destructors
+        static reaper& instance();
+
+        //thread is started on first post.
+        //Job posted after thread is stopped (while reaper is destroyed)
+        //is executed right away on calling thread
+        std::shared_future<void> post( std::function<void()> job );
+
+        //count of jobs not finished yet
+        unsigned pending() const;
+
+    private:
+        void run();
+
+    private:
+        struct job
+        {
+            std::function<void()> func;
+            std::promise<void> done;
+        };
+
+        mutable std::mutex _guard;
+        std::condition_variable _not_empty;
+        std::deque<job> _jobs;
+        //job which is executing right now
+        bool _busy;
+
+        std::thread _thread;
+        bool _running;
+        bool _stopping;
+    };
+}
@@ -25,14 +25,12 @@
 
 #include "vlc_subtitles.h"
 
-#include "vlc_helpers.h"
-
 using namespace vlc;
 
 unsigned subtitles::track_count()
 {
     if( _player.is_open() )
-        return libvlc_video_get_spu_count( _player.get_mp() );
+        return _tracks.count( _player.get_mp() );
 
     return 0;
 }
@@ -42,17 +40,7 @@ int subtitles::get_track()
     if( !_player.is_open() )
         return -1;
 
-    int track_idx = -1;
-    libvlc_track_description_t* tracks =
-        libvlc_video_get_spu_description( _player.get_mp() );
-
-    if( tracks ) {
-        track_idx = track_id_2_track_idx( tracks, libvlc_video_get_spu( _player.get_mp() ) );
-
-        libvlc_free( tracks );
-    }
-
-    return track_idx;
+    return _tracks.id_2_idx( _player.get_mp(), libvlc_video_get_spu( _player.get_mp() ) );
 }
 
 void subtitles::set_track( unsigned idx )
@@ -60,15 +48,17 @@ void subtitles::set_track( unsigned idx )
     if( !_player.is_open() )
         return;
 
-    libvlc_track_description_t* tracks =
-        libvlc_video_get_spu_description( _player.get_mp() );
-
-    if( tracks ) {
-        int id = track_idx_2_track_id( tracks, idx );
+    int id;
+    if( _tracks.idx_2_id( _player.get_mp(), idx, &id ) )
         libvlc_video_set_spu( _player.get_mp(), id );
+}
 
-        libvlc_free( tracks );
-    }
+std::string subtitles::get_track_name( unsigned idx )
+{
+    if( !_player.is_open() )
+        return std::string();
+
+    return _tracks.name( _player.get_mp(), idx );
 }
 
 int64_t subtitles::get_delay()
@@ -92,5 +82,11 @@ bool subtitles::load( const std::string& file )
     if( !_player.is_open() )
         return false;
 
-    return 0 != libvlc_video_set_subtitle_file( _player.get_mp(), file.c_str() );
+    const bool loaded = 0 != libvlc_video_set_subtitle_file( _player.get_mp(), file.c_str() );
+
+    //loaded subtitles are added to tracks table
+    if( loaded )
+        _tracks.invalidate();
+
+    return loaded;
 }
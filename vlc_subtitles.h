@@ -26,6 +26,7 @@
 #pragma once
 
 #include "vlc_basic_player.h"
+#include "vlc_helpers.h"
 
 namespace vlc
 {
@@ -33,13 +34,20 @@ namespace vlc
     {
     public:
         subtitles( vlc::basic_player& player )
-            : _player( player ) {}
+            : _player( player ), _tracks( libvlc_video_get_spu_description ) {}
 
         unsigned track_count();
 
         //can return -1 if there are no active subtitle
         int get_track();
         void set_track( unsigned );
+        std::string get_track_name( unsigned idx );
+
+        //see audio::set_tracks_cache, load() invalidates table itself
+        void set_tracks_cache( bool enable )
+            { _tracks.set_enabled( enable ); }
+        void invalidate_tracks()
+            { _tracks.invalidate(); }
 
         //in milliseconds
         int64_t get_delay();
@@ -49,5 +57,6 @@ namespace vlc
 
     private:
         vlc::basic_player& _player;
+        tracks_cache _tracks;
     };
 };
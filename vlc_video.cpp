@@ -25,12 +25,10 @@
 
 #include "vlc_video.h"
 
-#include "vlc_helpers.h"
-
 using namespace vlc;
 
 video::video( vlc::basic_player& player )
-    : _player( player )
+    : _player( player ), _tracks( libvlc_video_get_track_description )
 {
 }
 
@@ -123,8 +121,7 @@ unsigned video::track_count()
     if( !_player.is_open() )
         return 0;
 
-    int count = libvlc_video_get_track_count( _player.get_mp() );
-    return count < 0 ? 0 : count;
+    return _tracks.count( _player.get_mp() );
 }
 
 int video::get_track()
@@ -132,17 +129,7 @@ int video::get_track()
     if( !_player.is_open() )
         return -1;
 
-    int track_idx = -1;
-    libvlc_track_description_t* tracks =
-        libvlc_video_get_track_description( _player.get_mp() );
-
-    if( tracks ) {
-        track_idx = track_id_2_track_idx( tracks, libvlc_video_get_track( _player.get_mp() ) );
-
-        libvlc_free( tracks );
-    }
-
-    return track_idx;
+    return _tracks.id_2_idx( _player.get_mp(), libvlc_video_get_track( _player.get_mp() ) );
 }
 
 void video::set_track( unsigned idx )
@@ -150,13 +137,15 @@ void video::set_track( unsigned idx )
     if( !_player.is_open() )
         return;
 
-    libvlc_track_description_t* tracks =
-        libvlc_video_get_track_description( _player.get_mp() );
-
-    if( tracks ) {
-        int id = track_idx_2_track_id( tracks, idx );
+    int id;
+    if( _tracks.idx_2_id( _player.get_mp(), idx, &id ) )
         libvlc_video_set_track( _player.get_mp(), id );
+}
 
-        libvlc_free( tracks );
-    }
+std::string video::get_track_name( unsigned idx )
+{
+    if( !_player.is_open() )
+        return std::string();
+
+    return _tracks.name( _player.get_mp(), idx );
 }
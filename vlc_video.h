@@ -26,6 +26,7 @@
 #pragma once
 
 #include "vlc_basic_player.h"
+#include "vlc_helpers.h"
 
 namespace vlc
 {
@@ -39,6 +40,13 @@ namespace vlc
         //can return -1 if there is no active video track
         int get_track();
         void set_track( unsigned );
+        std::string get_track_name( unsigned idx );
+
+        //see audio::set_tracks_cache
+        void set_tracks_cache( bool enable )
+            { _tracks.set_enabled( enable ); }
+        void invalidate_tracks()
+            { _tracks.invalidate(); }
 
         bool has_vout();
 
@@ -82,5 +90,6 @@ namespace vlc
 
     private:
         vlc::basic_player& _player;
+        tracks_cache _tracks;
     };
 }
@@ -27,6 +27,8 @@
 
 #include <cstring>
 
+#include "vlc_reaper.h"
+
 using namespace vlc;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -45,6 +47,9 @@ bool basic_vmem_wrapper::open( vlc::basic_player* player )
     _mp = player->get_mp();
     libvlc_media_player_retain( _mp );
 
+    //pool can't reset video callbacks
+    player->disable_pool_reuse();
+
     libvlc_video_set_callbacks( _mp,
                                 video_fb_lock_proxy,
                                 video_fb_unlock_proxy,
@@ -69,11 +74,21 @@ void* video_fb_lock_stub( void*, void** planes )
     return 0;
 }
 
+void basic_vmem_wrapper::reset_callbacks( libvlc_media_player_t* mp )
+{
+    libvlc_video_set_callbacks( mp, video_fb_lock_stub, 0, 0, 0 );
+    libvlc_video_set_format_callbacks( mp, video_format_stub, 0 );
+}
+
 void basic_vmem_wrapper::close()
 {
+    if( _pending_close.valid() ) {
+        _pending_close.wait();
+        _pending_close = std::shared_future<void>();
+    }
+
     if( _mp ) {
-        libvlc_video_set_callbacks( _mp, video_fb_lock_stub, 0, 0, 0 );
-        libvlc_video_set_format_callbacks( _mp, video_format_stub, 0 );
+        reset_callbacks( _mp );
 
         //libvlc will continue to use old callbacks until playback will be stopped
         libvlc_media_player_stop( _mp );
@@ -82,6 +97,22 @@ void basic_vmem_wrapper::close()
     }
 }
 
+std::shared_future<void> basic_vmem_wrapper::close_async()
+{
+    if( libvlc_media_player_t* mp = _mp ) {
+        _mp = 0;
+
+        reset_callbacks( mp );
+
+        _pending_close = reaper::instance().post( [mp] () {
+            libvlc_media_player_stop( mp );
+            libvlc_media_player_release( mp );
+        } );
+    }
+
+    return _pending_close;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class vlc::vmem
 ////////////////////////////////////////////////////////////////////////////////
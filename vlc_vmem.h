@@ -39,6 +39,11 @@ namespace vlc
 
         bool open( vlc::basic_player* player );
         void close();
+        //media player is stopped and released on reaper thread,
+        //but libvlc could use callbacks until it is stopped,
+        //so wrapper should be alive until returned future is ready
+        //(open/close/destructor wait for it)
+        std::shared_future<void> close_async();
 
     private:
         //for libvlc_video_set_format_callbacks
@@ -75,8 +80,13 @@ namespace vlc
         virtual void  video_display_cb( void *picture ) = 0;
         //end (for libvlc_video_set_callbacks)
 
+    private:
+        //set callbacks stubs to be used after close
+        static void reset_callbacks( libvlc_media_player_t* );
+
     private:
         libvlc_media_player_t* _mp;
+        std::shared_future<void> _pending_close;
     };
 
     const char DEF_CHROMA[] = "RV32";